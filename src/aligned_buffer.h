@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+// Allocator for frame-sized buffers. Every allocation is cache-line (64 byte)
+// aligned so SIMD loads never straddle lines; allocations of at least one
+// huge page are aligned to 2 MiB and, on Linux, advised to use transparent
+// huge pages to cut TLB misses on large render targets. Elements are
+// default-initialized, so resizing a buffer of ints or pixels does not
+// write (and first-touch) its pages; see allocateFirstTouch.
+template <typename T, std::size_t Alignment = 64>
+class AlignedAllocator {
+public:
+    using value_type = T;
+    
+    template <typename U>
+    struct rebind { using other = AlignedAllocator<U, Alignment>; };
+    
+    static const std::size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+    
+    AlignedAllocator() noexcept {}
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+    
+    T* allocate(std::size_t n) {
+        std::size_t bytes = n * sizeof(T);
+        std::size_t alignment = bytes >= HUGE_PAGE_SIZE ? HUGE_PAGE_SIZE : Alignment;
+        bytes = (bytes + alignment - 1) / alignment * alignment;
+        
+        void* ptr = nullptr;
+#ifdef _WIN32
+        ptr = _aligned_malloc(bytes, alignment);
+#else
+        if (posix_memalign(&ptr, alignment, bytes) != 0) {
+            ptr = nullptr;
+        }
+#endif
+        if (!ptr) {
+            throw std::bad_alloc();
+        }
+        
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        if (alignment == HUGE_PAGE_SIZE) {
+            madvise(ptr, bytes, MADV_HUGEPAGE); // Only a hint, failure is harmless
+        }
+#endif
+        return static_cast<T*>(ptr);
+    }
+    
+    template <typename U>
+    void construct(U* ptr) {
+        ::new (static_cast<void*>(ptr)) U;
+    }
+    
+    template <typename U, typename... Args>
+    void construct(U* ptr, Args&&... args) {
+        ::new (static_cast<void*>(ptr)) U(std::forward<Args>(args)...);
+    }
+    
+    void deallocate(T* ptr, std::size_t) noexcept {
+#ifdef _WIN32
+        _aligned_free(ptr);
+#else
+        free(ptr);
+#endif
+    }
+};
+
+template <typename T, typename U, std::size_t Alignment>
+bool operator==(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&) { return true; }
+
+template <typename T, typename U, std::size_t Alignment>
+bool operator!=(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&) { return false; }
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
@@ -0,0 +1,137 @@
+#include "benchmark_cache.h"
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace {
+const char* CACHE_FILE_NAME = "almond_benchmark.cache";
+#ifdef ALMOND_BUILD_ID
+const char* BUILD_ID = ALMOND_BUILD_ID;
+#else
+const char* BUILD_ID = __DATE__ " " __TIME__;
+#endif
+}
+
+BenchmarkCache::BenchmarkCache() : path_(defaultPath()) {
+}
+
+BenchmarkCache::BenchmarkCache(const std::string& path) : path_(path) {
+}
+
+std::string BenchmarkCache::defaultPath() {
+#ifdef _WIN32
+    const char* dir = std::getenv("LOCALAPPDATA");
+    if (dir) return std::string(dir) + "\\" + CACHE_FILE_NAME;
+#else
+    const char* dir = std::getenv("XDG_CACHE_HOME");
+    if (dir && *dir) return std::string(dir) + "/" + CACHE_FILE_NAME;
+    
+    const char* home = std::getenv("HOME");
+    if (home && *home) return std::string(home) + "/.cache/" + CACHE_FILE_NAME;
+#endif
+    return CACHE_FILE_NAME;
+}
+
+std::string BenchmarkCache::getCPUModel() {
+#ifdef _WIN32
+    const char* identifier = std::getenv("PROCESSOR_IDENTIFIER");
+    if (identifier) return identifier;
+#else
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.compare(0, 10, "model name") == 0) {
+            size_t colon = line.find(':');
+            if (colon != std::string::npos) {
+                size_t start = line.find_first_not_of(" \t", colon + 1);
+                return start == std::string::npos ? "unknown" : line.substr(start);
+            }
+        }
+    }
+#endif
+    return "unknown";
+}
+
+std::string BenchmarkCache::makeKey(int thread_count, const AffinityConfig& affinity) {
+    std::ostringstream oss;
+    oss << getCPUModel() << "|" << thread_count << "|" << describeAffinity(affinity) << "|" << BUILD_ID << "|suite" << BENCHMARK_SUITE_VERSION;
+    return oss.str();
+}
+
+bool BenchmarkCache::load(const std::string& key, BenchmarkResult& result) const {
+    std::ifstream file(path_);
+    std::string line;
+    
+    while (std::getline(file, line)) {
+        if (line.compare(0, key.size() + 1, key + "\t") != 0) continue;
+        
+        std::istringstream values(line.substr(key.size() + 1));
+        BenchmarkResult cached;
+        if (!(values >> cached.single_thread_ms >> cached.multi_thread_ms
+                    >> cached.thread_count >> cached.almond_score)) {
+            continue;
+        }
+        
+        // Per-scene breakdown, in suite order; the suite version in the key
+        // guarantees the scenes match. Older entries end before it.
+        const auto& scenes = getBenchmarkScenes();
+        size_t scene_count = 0;
+        if (values >> scene_count && scene_count == scenes.size()) {
+            for (size_t i = 0; i < scene_count; ++i) {
+                SceneResult scene;
+                scene.name = scenes[i].name;
+                if (!(values >> scene.single_thread_ms >> scene.multi_thread_ms >> scene.total_iterations
+                             >> scene.score >> scene.checksum_ok)) {
+                    cached.scenes.clear();
+                    break;
+                }
+                cached.valid = cached.valid && scene.checksum_ok;
+                cached.scenes.push_back(scene);
+            }
+        }
+        
+        result = cached;
+        return true;
+    }
+    
+    return false;
+}
+
+bool BenchmarkCache::store(const std::string& key, const BenchmarkResult& result) const {
+    // Keep entries for other machines and builds, replace our own
+    std::vector<std::string> lines;
+    {
+        std::ifstream file(path_);
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.compare(0, key.size() + 1, key + "\t") != 0) {
+                lines.push_back(line);
+            }
+        }
+    }
+    
+    std::ostringstream entry;
+    entry << key << "\t" << result.single_thread_ms << " " << result.multi_thread_ms
+          << " " << result.thread_count << " " << result.almond_score << " " << result.scenes.size();
+    for (const auto& scene : result.scenes) {
+        entry << " " << scene.single_thread_ms << " " << scene.multi_thread_ms << " " << scene.total_iterations
+              << " " << scene.score << " " << scene.checksum_ok;
+    }
+    lines.push_back(entry.str());
+    
+    std::error_code error;
+    std::filesystem::path parent = std::filesystem::path(path_).parent_path();
+    if (!parent.empty()) {
+        std::filesystem::create_directories(parent, error);
+    }
+    
+    std::ofstream file(path_, std::ios::trunc);
+    if (!file) return false;
+    
+    for (const auto& line : lines) {
+        file << line << "\n";
+    }
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include "benchmark_runner.h"
+
+// Persists benchmark results in a small text file so repeat launches can
+// show the last score without re-running. Entries are keyed by CPU model,
+// thread count, thread affinity, build and suite version, so a result is
+// never shown for other hardware or an incomparable scene suite. Each entry
+// keeps the per-scene times, scores and checksum results as well.
+class BenchmarkCache {
+public:
+    BenchmarkCache();
+    explicit BenchmarkCache(const std::string& path);
+    
+    static std::string makeKey(int thread_count, const AffinityConfig& affinity);
+    static std::string getCPUModel();
+    
+    bool load(const std::string& key, BenchmarkResult& result) const;
+    bool store(const std::string& key, const BenchmarkResult& result) const;
+    
+    const std::string& getPath() const { return path_; }
+    
+private:
+    static std::string defaultPath();
+    
+    std::string path_;
+};
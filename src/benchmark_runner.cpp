@@ -0,0 +1,213 @@
+#include "benchmark_runner.h"
+#include <chrono>
+
+namespace {
+const int BACKEND_FRAMES = 3;
+const int FORK_JOIN_RUNS = 200;
+
+int countAvailableBackends() {
+    int count = 0;
+    for (int type = 0; type < ParallelBackend::BACKEND_COUNT; ++type) {
+        count += ParallelBackend::isAvailable(static_cast<ParallelBackend::Type>(type));
+    }
+    return count;
+}
+}
+
+const char* getAlmondRating(int almond_score) {
+    if (almond_score >= 2000) return "EXCELLENT!";
+    if (almond_score >= 1000) return "VERY GOOD";
+    if (almond_score >= 500) return "GOOD";
+    if (almond_score >= 200) return "AVERAGE";
+    return "NEEDS IMPROVEMENT";
+}
+
+const BenchmarkScene& getBackendComparisonScene() {
+    // Seahorse valley: mixed cheap and expensive rows, so scheduling matters
+    return getBenchmarkScenes()[2];
+}
+
+BackendResult measureBackend(ParallelBackend::Type type, int thread_count, const BenchmarkScene& scene,
+                             const AffinityConfig& affinity) {
+    MandelbrotCalculator calculator(scene.params.width, scene.params.height, type, thread_count, affinity);
+    
+    BackendResult result;
+    result.type = calculator.getParallelBackend().getType();
+    
+    // Warm-up: thread creation, TBB arena setup, first touch of the buffer
+    calculator.calculateParallel(scene.params);
+    
+    // Per-frame runtime cost with no work in the chunks
+    ParallelBackend& backend = calculator.getParallelBackend();
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < FORK_JOIN_RUNS; ++i) {
+        backend.parallelFor(scene.params.height, [](int, int) {});
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    result.fork_join_us = std::chrono::duration<double, std::micro>(end - start).count() / FORK_JOIN_RUNS;
+    
+    result.frame_ms = calculator.benchmarkParallel(scene.params, BACKEND_FRAMES);
+    result.checksum_ok = checksumIterations(calculator.getIterations()) == scene.checksum;
+    if (result.frame_ms > 0.0) {
+        result.score = countIterations(calculator.getIterations()) / (result.frame_ms * 1000.0);
+    }
+    return result;
+}
+
+NodeResult measureNode(const NumaNode& node, const BenchmarkScene& scene) {
+    AffinityConfig affinity;
+    affinity.policy = AffinityPolicy::CORE_LIST;
+    affinity.cores = node.cpus;
+    
+    BackendResult measured = measureBackend(ParallelBackend::OPENMP, static_cast<int>(node.cpus.size()), scene, affinity);
+    
+    NodeResult result;
+    result.node = node.id;
+    result.threads = static_cast<int>(node.cpus.size());
+    result.frame_ms = measured.frame_ms;
+    result.score = measured.score;
+    result.checksum_ok = measured.checksum_ok;
+    return result;
+}
+
+BenchmarkRunner::BenchmarkRunner()
+    : running_(false), cancel_(false), completed_steps_(0), measuring_(false), foreground_waiting_(false),
+      foreground_busy_(false), result_ready_(false) {
+}
+
+BenchmarkRunner::~BenchmarkRunner() {
+    cancel();
+}
+
+void BenchmarkRunner::start(int thread_count, const AffinityConfig& affinity) {
+    cancel();
+    
+    cancel_ = false;
+    completed_steps_ = 0;
+    running_ = true;
+    worker_ = std::thread(&BenchmarkRunner::run, this, thread_count, affinity);
+}
+
+void BenchmarkRunner::cancel() {
+    cancel_ = true;
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    running_ = false;
+}
+
+double BenchmarkRunner::getProgress() const {
+    return static_cast<double>(completed_steps_) / (getBenchmarkScenes().size() * (1 + RUNS) + countAvailableBackends()
+                                                  + NumaTopology::get().getNodes().size());
+}
+
+void BenchmarkRunner::beginForegroundFrame() {
+    std::unique_lock<std::mutex> lock(turn_mutex_);
+    foreground_waiting_ = true;
+    turn_cv_.wait(lock, [this] { return !measuring_; });
+    foreground_waiting_ = false;
+    foreground_busy_ = true;
+}
+
+void BenchmarkRunner::endForegroundFrame() {
+    {
+        std::lock_guard<std::mutex> lock(turn_mutex_);
+        foreground_busy_ = false;
+    }
+    turn_cv_.notify_all();
+}
+
+void BenchmarkRunner::beginStep() {
+    // A waiting frame goes first, so the window advances between steps
+    std::unique_lock<std::mutex> lock(turn_mutex_);
+    turn_cv_.wait(lock, [this] { return !foreground_busy_ && !foreground_waiting_; });
+    measuring_ = true;
+}
+
+void BenchmarkRunner::endStep() {
+    {
+        std::lock_guard<std::mutex> lock(turn_mutex_);
+        measuring_ = false;
+    }
+    turn_cv_.notify_all();
+}
+
+bool BenchmarkRunner::takeResult(BenchmarkResult& result) {
+    std::lock_guard<std::mutex> lock(result_mutex_);
+    if (!result_ready_) return false;
+    
+    result = result_;
+    result_ready_ = false;
+    return true;
+}
+
+void BenchmarkRunner::run(int thread_count, const AffinityConfig& affinity) {
+    // The score is always measured on OpenMP so it stays comparable with
+    // cached results, the other backends only get the comparison below.
+    // This thread has its own OpenMP team, pinning it leaves the render
+    // thread's team alone.
+    MandelbrotCalculator calculator(1, 1, ParallelBackend::OPENMP, thread_count, affinity);
+    BenchmarkResult result;
+    result.thread_count = thread_count;
+    
+    for (const auto& scene : getBenchmarkScenes()) {
+        if (cancel_) break;
+        
+        SceneResult scene_result;
+        scene_result.name = scene.name;
+        
+        beginStep();
+        scene_result.single_thread_ms = calculator.benchmarkSingle(scene.params, 1);
+        endStep();
+        bool single_ok = checksumIterations(calculator.getIterations()) == scene.checksum;
+        scene_result.total_iterations = countIterations(calculator.getIterations());
+        ++completed_steps_;
+        
+        for (int i = 0; i < RUNS && !cancel_; ++i) {
+            beginStep();
+            scene_result.multi_thread_ms += calculator.benchmarkParallel(scene.params, 1) / RUNS;
+            endStep();
+            ++completed_steps_;
+        }
+        bool multi_ok = checksumIterations(calculator.getIterations()) == scene.checksum;
+        
+        scene_result.checksum_ok = single_ok && multi_ok;
+        if (scene_result.multi_thread_ms > 0.0) {
+            scene_result.score = scene_result.total_iterations / (scene_result.multi_thread_ms * 1000.0);
+        }
+        
+        result.single_thread_ms += scene_result.single_thread_ms;
+        result.multi_thread_ms += scene_result.multi_thread_ms;
+        result.valid = result.valid && scene_result.checksum_ok;
+        result.scenes.push_back(scene_result);
+    }
+    
+    for (int type = 0; type < ParallelBackend::BACKEND_COUNT && !cancel_; ++type) {
+        if (!ParallelBackend::isAvailable(static_cast<ParallelBackend::Type>(type))) continue;
+        
+        beginStep();
+        result.backends.push_back(measureBackend(static_cast<ParallelBackend::Type>(type), thread_count,
+                                                 getBackendComparisonScene(), affinity));
+        endStep();
+        ++completed_steps_;
+    }
+    
+    for (const auto& node : NumaTopology::get().getNodes()) {
+        if (cancel_) break;
+        
+        beginStep();
+        result.nodes.push_back(measureNode(node, getBackendComparisonScene()));
+        endStep();
+        ++completed_steps_;
+    }
+    
+    if (!cancel_) {
+        result.almond_score = static_cast<int>(computeCompositeScore(result.scenes));
+        
+        std::lock_guard<std::mutex> lock(result_mutex_);
+        result_ = result;
+        result_ready_ = true;
+    }
+    
+    running_ = false;
+}
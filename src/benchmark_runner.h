@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "mandelbrot.h"
+#include "benchmark_suite.h"
+#include "parallel_backend.h"
+
+// One threading runtime on the backend comparison scene
+struct BackendResult {
+    ParallelBackend::Type type = ParallelBackend::OPENMP;
+    double fork_join_us = 0.0; // Empty parallelFor over the scene's rows
+    double frame_ms = 0.0;
+    double score = 0.0;        // Million iterations per second
+    bool checksum_ok = false;
+};
+
+// The comparison scene on one NUMA node's CPUs only
+struct NodeResult {
+    int node = 0;
+    int threads = 0;
+    double frame_ms = 0.0;
+    double score = 0.0;
+    bool checksum_ok = false;
+};
+
+struct BenchmarkResult {
+    double single_thread_ms = 0.0; // Summed over all scenes
+    double multi_thread_ms = 0.0;
+    int thread_count = 0;
+    int almond_score = 0;          // Composite score of the scene suite
+    bool valid = true;             // False if any scene checksum mismatched
+    std::vector<SceneResult> scenes;
+    std::vector<BackendResult> backends; // Not part of the score
+    std::vector<NodeResult> nodes;
+};
+
+const char* getAlmondRating(int almond_score);
+
+// Scene every backend is compared on
+const BenchmarkScene& getBackendComparisonScene();
+
+BackendResult measureBackend(ParallelBackend::Type type, int thread_count, const BenchmarkScene& scene,
+                             const AffinityConfig& affinity = AffinityConfig());
+NodeResult measureNode(const NumaNode& node, const BenchmarkScene& scene);
+
+// Runs the canonical scene suite on a background thread with its own
+// calculator so the window keeps rendering while it measures. Interactive
+// frames and measured steps take turns: a frame bracketed by
+// begin/endForegroundFrame waits for the step in progress, and the next
+// step waits for the frame, so neither is timed under the other's load.
+class BenchmarkRunner {
+public:
+    BenchmarkRunner();
+    ~BenchmarkRunner();
+    
+    // The suite runs on OpenMP threads placed by affinity
+    void start(int thread_count, const AffinityConfig& affinity = AffinityConfig());
+    void cancel();
+    
+    bool isRunning() const { return running_; }
+    
+    void beginForegroundFrame();
+    void endForegroundFrame();
+    double getProgress() const;
+    
+    // Returns true once per finished run and hands out its result
+    bool takeResult(BenchmarkResult& result);
+
+private:
+    void run(int thread_count, const AffinityConfig& affinity);
+    void beginStep();
+    void endStep();
+    
+    std::thread worker_;
+    std::atomic<bool> running_;
+    std::atomic<bool> cancel_;
+    std::atomic<int> completed_steps_;
+    
+    std::mutex turn_mutex_;
+    std::condition_variable turn_cv_;
+    bool measuring_;
+    bool foreground_waiting_;
+    bool foreground_busy_;
+    
+    std::mutex result_mutex_;
+    BenchmarkResult result_;
+    bool result_ready_;
+    
+    static const int RUNS = 3; // Multi-threaded runs per scene, after one single-threaded run
+};
@@ -0,0 +1,51 @@
+#include "benchmark_suite.h"
+#include <cmath>
+
+const std::vector<BenchmarkScene>& getBenchmarkScenes() {
+    // Checksums assume IEEE double arithmetic without FMA contraction
+    // (see -ffp-contract=off in CMakeLists.txt)
+    static const std::vector<BenchmarkScene> scenes = {
+        {"Exterior", "per-pixel overhead, memory bandwidth",
+         {1.5, 1.5, 2.0, 256, 640, 480}, 0xeeaa14bc46591ea7ULL},
+        {"Interior", "pure arithmetic, every pixel hits the limit",
+         {-0.15, 0.0, 40.0, 512, 640, 480}, 0xbc2719806a282325ULL},
+        {"Seahorse", "boundary, load imbalance between rows",
+         {-0.75, 0.1, 20.0, 1024, 640, 480}, 0x2a8347cc04951e34ULL},
+        {"Deep zoom", "pixel spacing about 3 double ulps at y = 1",
+         {0.0, 1.0, 1e13, 2048, 640, 480}, 0xa40084a11b41024fULL},
+        {"Mini-brot", "high iteration count around a period-3 mini-brot",
+         {-1.7548776662466927, 0.0, 66.0, 4096, 640, 480}, 0xc6ba51f144e80bf8ULL},
+    };
+    return scenes;
+}
+
+uint64_t checksumIterations(const IterationBuffer& iterations) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (int value : iterations) {
+        uint32_t bits = static_cast<uint32_t>(value);
+        for (int byte = 0; byte < 4; ++byte) {
+            hash ^= (bits >> (8 * byte)) & 0xFF;
+            hash *= 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+uint64_t countIterations(const IterationBuffer& iterations) {
+    uint64_t total = 0;
+    for (int value : iterations) {
+        total += static_cast<uint64_t>(value);
+    }
+    return total;
+}
+
+double computeCompositeScore(const std::vector<SceneResult>& scenes) {
+    if (scenes.empty()) return 0.0;
+    
+    double log_sum = 0.0;
+    for (const auto& scene : scenes) {
+        if (scene.score <= 0.0) return 0.0;
+        log_sum += std::log(scene.score);
+    }
+    return std::exp(log_sum / scenes.size());
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "mandelbrot.h"
+
+// Bump whenever a scene, its checksum or the scoring changes: scores from
+// different suite versions are not comparable
+const int BENCHMARK_SUITE_VERSION = 1;
+
+// A fixed view with fixed resolution and iteration count, so the Almond
+// Score no longer depends on where the user happens to be looking
+struct BenchmarkScene {
+    const char* name;
+    const char* stresses;
+    MandelbrotParams params;
+    uint64_t checksum; // FNV-1a 64 of the iteration buffer
+};
+
+struct SceneResult {
+    std::string name;
+    double single_thread_ms = 0.0;
+    double multi_thread_ms = 0.0;
+    uint64_t total_iterations = 0;
+    double score = 0.0; // Million iterations per second, multi-threaded
+    bool checksum_ok = false;
+};
+
+const std::vector<BenchmarkScene>& getBenchmarkScenes();
+
+uint64_t checksumIterations(const IterationBuffer& iterations);
+uint64_t countIterations(const IterationBuffer& iterations);
+
+// Geometric mean of the scene scores, so no single scene dominates
+double computeCompositeScore(const std::vector<SceneResult>& scenes);
@@ -2,7 +2,8 @@
 #include <cmath>
 #include <algorithm>
 
-ColorPalette::ColorPalette(PaletteType type, int size) : current_type_(type) {
+ColorPalette::ColorPalette(PaletteType type, int size)
+    : current_type_(type), coloring_mode_(LINEAR), equalized_max_iterations_(0) {
     colors_.reserve(size);
     setPaletteType(type);
 }
@@ -12,12 +13,45 @@ Color ColorPalette::getColor(int iterations, int max_iterations) const {
         return Color(0, 0, 0); // Black for points in the set
     }
     
+    if (coloring_mode_ == HISTOGRAM && max_iterations == equalized_max_iterations_) {
+        return colors_[equalized_index_[iterations]];
+    }
+    
     // Smooth coloring using continuous iteration count
     double smooth_iter = iterations + 1 - std::log2(std::log2(2.0));
     int index = static_cast<int>(smooth_iter * colors_.size() / max_iterations) % colors_.size();
     return colors_[std::max(0, std::min(static_cast<int>(colors_.size()) - 1, index))];
 }
 
+void ColorPalette::equalize(const std::vector<uint32_t>& histogram, int max_iterations) {
+    equalized_index_.assign(max_iterations + 1, 0);
+    equalized_max_iterations_ = max_iterations;
+    
+    // Points in the set stay black, so only escaped pixels shape the CDF
+    uint64_t escaped = 0;
+    for (int i = 0; i < max_iterations && i < static_cast<int>(histogram.size()); ++i) {
+        escaped += histogram[i];
+    }
+    if (escaped == 0) return;
+    
+    const int last = static_cast<int>(colors_.size()) - 1;
+    uint64_t cumulative = 0;
+    for (int i = 0; i < max_iterations; ++i) {
+        if (i < static_cast<int>(histogram.size())) {
+            cumulative += histogram[i];
+        }
+        equalized_index_[i] = static_cast<uint16_t>(cumulative * last / escaped);
+    }
+}
+
+void ColorPalette::buildLookup(int max_iterations, std::vector<uint32_t>& lookup) const {
+    lookup.resize(max_iterations + 1);
+    for (int i = 0; i <= max_iterations; ++i) {
+        Color color = getColor(i, max_iterations);
+        lookup[i] = (color.a << 24) | (color.r << 16) | (color.g << 8) | color.b;
+    }
+}
+
 void ColorPalette::setPaletteType(PaletteType type) {
     current_type_ = type;
     colors_.clear();
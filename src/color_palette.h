@@ -21,11 +21,29 @@ public:
         ELECTRIC
     };
     
+    // LINEAR maps iterations modulo the palette; HISTOGRAM spreads colors by
+    // the iteration CDF of the current frame so narrow bands keep contrast
+    enum ColoringMode {
+        LINEAR,
+        HISTOGRAM
+    };
+    
     ColorPalette(PaletteType type = CLASSIC, int size = 256);
     
     Color getColor(int iterations, int max_iterations) const;
     void setPaletteType(PaletteType type);
     
+    void setColoringMode(ColoringMode mode) { coloring_mode_ = mode; }
+    ColoringMode getColoringMode() const { return coloring_mode_; }
+    
+    // Builds the equalization lookup table from an iteration histogram with
+    // max_iterations + 1 bins
+    void equalize(const std::vector<uint32_t>& histogram, int max_iterations);
+    
+    // ARGB8888 pixel for every iteration count 0..max_iterations, so
+    // colorizing a pixel is one table lookup
+    void buildLookup(int max_iterations, std::vector<uint32_t>& lookup) const;
+    
 private:
     void generateClassic();
     void generateFire();
@@ -36,4 +54,7 @@ private:
     
     std::vector<Color> colors_;
     PaletteType current_type_;
+    ColoringMode coloring_mode_;
+    std::vector<uint16_t> equalized_index_; // Palette index per iteration count
+    int equalized_max_iterations_;
 };
@@ -1,10 +1,34 @@
 #include "fps_counter.h"
 #include <algorithm>
-#include <numeric>
+#include <cmath>
 #include <sstream>
 #include <iomanip>
 
-FPSCounter::FPSCounter() : current_fps_(0.0) {
+std::string FrameStats::toString() const {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(2);
+    oss << frames << " frames | avg " << average_ms << " ms | p50 " << p50_ms
+        << " | p95 " << p95_ms << " | p99 " << p99_ms << " | max " << max_ms
+        << " ms | 1% low " << std::setprecision(1) << low_1pct_fps << " FPS";
+    return oss.str();
+}
+
+FPSCounter::FPSCounter(const std::vector<int>& windows)
+    : current_fps_(0.0), write_index_(0), read_index_(0), dropped_samples_(0), history_count_(0) {
+    int largest = 1;
+    for (int size : windows) {
+        Histogram window;
+        window.size = std::max(1, size);
+        windows_.push_back(window);
+        largest = std::max(largest, window.size);
+    }
+    if (windows_.empty()) {
+        Histogram window;
+        window.size = 120;
+        windows_.push_back(window);
+        largest = window.size;
+    }
+    history_.assign(largest, 0);
     last_time_ = std::chrono::high_resolution_clock::now();
 }
 
@@ -16,55 +40,190 @@ void FPSCounter::update() {
     
     if (frame_time > 0.0) {
         current_fps_ = 1.0 / frame_time;
+        recordFrameTime(frame_time * 1000.0);
+    }
+    
+    last_time_ = current_time;
+    drain();
+}
+
+void FPSCounter::recordFrameTime(double frame_ms) {
+    const double max_us = static_cast<double>((1u << (MAX_OCTAVE + 1)) - 1);
+    uint32_t frame_us = static_cast<uint32_t>(std::max(1.0, std::min(max_us, frame_ms * 1000.0 + 0.5)));
+    
+    uint64_t index = write_index_.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = ring_[index % RING_CAPACITY];
+    // Mark the slot as being written before touching the value, so a reader
+    // that saw the old sequence notices the overwrite on its second load
+    slot.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.frame_us.store(frame_us, std::memory_order_relaxed);
+    slot.sequence.store(index + 1, std::memory_order_release);
+}
+
+void FPSCounter::drain() {
+    const uint64_t end = write_index_.load(std::memory_order_acquire);
+    if (end - read_index_ > RING_CAPACITY) {
+        dropped_samples_ += end - RING_CAPACITY - read_index_;
+        read_index_ = end - RING_CAPACITY;
+    }
+    
+    const uint64_t first = read_index_;
+    while (read_index_ < end) {
+        Slot& slot = ring_[read_index_ % RING_CAPACITY];
+        uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence < read_index_ + 1) break; // Claimed, not written yet
         
-        frame_times_.push_back(frame_time);
+        uint32_t frame_us = slot.frame_us.load(std::memory_order_relaxed);
+        // A writer that lapped the ring may have replaced the value meanwhile;
+        // the fence keeps the value load ahead of the second sequence load
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence != read_index_ + 1 || slot.sequence.load(std::memory_order_relaxed) != sequence) {
+            ++dropped_samples_;
+            ++read_index_;
+            continue;
+        }
+        ++read_index_;
         
-        // Keep only the last MAX_SAMPLES frame times
-        if (frame_times_.size() > MAX_SAMPLES) {
-            frame_times_.pop_front();
+        const int bucket = bucketOf(frame_us);
+        const size_t history_size = history_.size();
+        for (auto& window : windows_) {
+            if (history_count_ >= static_cast<uint64_t>(window.size)) {
+                uint32_t leaving_us = history_[(history_count_ - window.size) % history_size];
+                window.remove(bucketOf(leaving_us), leaving_us);
+            }
+            window.add(bucket, frame_us);
         }
+        session_.add(bucket, frame_us);
+        history_[history_count_ % history_size] = frame_us;
+        ++history_count_;
     }
     
-    last_time_ = current_time;
+    if (read_index_ != first) {
+        for (auto& window : windows_) {
+            window.updateStats();
+        }
+        session_.updateStats();
+    }
 }
 
-double FPSCounter::getAverageFPS() const {
-    if (frame_times_.empty()) return 0.0;
+int FPSCounter::bucketOf(uint32_t frame_us) {
+    if (frame_us < SUB_BUCKETS) return static_cast<int>(frame_us);
     
-    double avg_frame_time = std::accumulate(frame_times_.begin(), frame_times_.end(), 0.0) / frame_times_.size();
-    return avg_frame_time > 0.0 ? 1.0 / avg_frame_time : 0.0;
+    int octave = SUB_BUCKET_BITS;
+    while (octave < MAX_OCTAVE && (frame_us >> (octave + 1)) != 0) ++octave;
+    
+    int sub_bucket = (frame_us >> (octave - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return (octave - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub_bucket;
 }
 
-double FPSCounter::getMinFPS() const {
-    if (frame_times_.empty()) return 0.0;
+double FPSCounter::bucketMidpointUs(int bucket) {
+    if (bucket < SUB_BUCKETS) return bucket + 0.5;
     
-    auto max_frame_time = *std::max_element(frame_times_.begin(), frame_times_.end());
-    return max_frame_time > 0.0 ? 1.0 / max_frame_time : 0.0;
+    int octave = bucket / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    int sub_bucket = bucket % SUB_BUCKETS;
+    double width = std::ldexp(1.0, octave - SUB_BUCKET_BITS);
+    return (SUB_BUCKETS + sub_bucket) * width + width * 0.5;
 }
 
-double FPSCounter::getMaxFPS() const {
-    if (frame_times_.empty()) return 0.0;
+void FPSCounter::Histogram::add(int bucket, uint32_t frame_us) {
+    ++counts[bucket];
+    ++frames;
+    total_us += frame_us;
+}
+
+void FPSCounter::Histogram::remove(int bucket, uint32_t frame_us) {
+    --counts[bucket];
+    --frames;
+    total_us -= frame_us;
+}
+
+void FPSCounter::Histogram::clear() {
+    counts.fill(0);
+    frames = 0;
+    total_us = 0;
+    stats = FrameStats();
+}
+
+void FPSCounter::Histogram::updateStats() {
+    stats = FrameStats();
+    stats.frames = frames;
+    if (frames == 0) return;
     
-    auto min_frame_time = *std::min_element(frame_times_.begin(), frame_times_.end());
-    return min_frame_time > 0.0 ? 1.0 / min_frame_time : 0.0;
+    stats.average_ms = total_us / 1000.0 / frames;
+    
+    // Nearest-rank percentiles from one pass over the buckets
+    const uint64_t rank50 = (frames * 50 + 99) / 100;
+    const uint64_t rank95 = (frames * 95 + 99) / 100;
+    const uint64_t rank99 = (frames * 99 + 99) / 100;
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        if (counts[bucket] == 0) continue;
+        
+        double ms = bucketMidpointUs(bucket) / 1000.0;
+        if (seen == 0) stats.min_ms = ms;
+        uint64_t before = seen;
+        seen += counts[bucket];
+        if (before < rank50 && seen >= rank50) stats.p50_ms = ms;
+        if (before < rank95 && seen >= rank95) stats.p95_ms = ms;
+        if (before < rank99 && seen >= rank99) stats.p99_ms = ms;
+        stats.max_ms = ms;
+    }
+    
+    // Mean of the slowest 1% (at least one frame), walking down from the top
+    uint64_t remaining = std::max<uint64_t>(1, frames / 100);
+    const uint64_t slow_frames = remaining;
+    double slow_us = 0.0;
+    for (int bucket = BUCKET_COUNT - 1; bucket >= 0 && remaining > 0; --bucket) {
+        uint64_t taken = std::min<uint64_t>(remaining, counts[bucket]);
+        slow_us += taken * bucketMidpointUs(bucket);
+        remaining -= taken;
+    }
+    stats.low_1pct_fps = slow_us > 0.0 ? 1000000.0 * slow_frames / slow_us : 0.0;
+}
+
+double FPSCounter::getAverageFPS() const {
+    const FrameStats& stats = windows_[0].stats;
+    return stats.average_ms > 0.0 ? 1000.0 / stats.average_ms : 0.0;
+}
+
+double FPSCounter::getMinFPS() const {
+    const FrameStats& stats = windows_[0].stats;
+    return stats.max_ms > 0.0 ? 1000.0 / stats.max_ms : 0.0;
+}
+
+double FPSCounter::getMaxFPS() const {
+    const FrameStats& stats = windows_[0].stats;
+    return stats.min_ms > 0.0 ? 1000.0 / stats.min_ms : 0.0;
+}
+
+void FPSCounter::beginSession() {
+    drain();
+    session_.clear();
 }
 
 std::string FPSCounter::getStatsString() const {
+    const FrameStats& stats = windows_[0].stats;
     std::ostringstream oss;
     oss << std::fixed << std::setprecision(1);
     oss << "FPS: " << current_fps_;
     
-    if (!frame_times_.empty()) {
+    if (stats.frames > 0) {
         oss << " | Avg: " << getAverageFPS();
-        oss << " | Min: " << getMinFPS();
-        oss << " | Max: " << getMaxFPS();
+        oss << " | 1% low: " << stats.low_1pct_fps;
+        oss << " | p99: " << stats.p99_ms << "ms";
     }
     
     return oss.str();
 }
 
 void FPSCounter::reset() {
-    frame_times_.clear();
+    drain();
+    for (auto& window : windows_) {
+        window.clear();
+    }
+    session_.clear();
+    history_count_ = 0;
     current_fps_ = 0.0;
     last_time_ = std::chrono::high_resolution_clock::now();
 }
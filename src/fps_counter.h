@@ -1,27 +1,103 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <chrono>
-#include <deque>
+#include <cstdint>
 #include <string>
+#include <vector>
 
+// Frame-time summary of one window, refreshed when new frames arrive so
+// every getter is a plain lookup
+struct FrameStats {
+    uint64_t frames = 0;
+    double average_ms = 0.0;
+    double min_ms = 0.0;
+    double p50_ms = 0.0;
+    double p95_ms = 0.0;
+    double p99_ms = 0.0;
+    double max_ms = 0.0;
+    double low_1pct_fps = 0.0; // FPS over the slowest 1% of frames
+    
+    std::string toString() const;
+};
+
+// Frame times go into a fixed ring that any thread can write without
+// locking; the render thread drains it in update() into log-bucketed
+// histograms (16 buckets per power of two, about 3% resolution) over
+// sliding windows of the last N frames plus a session histogram.
 class FPSCounter {
 public:
-    FPSCounter();
+    // Window sizes in frames, the first one drives the HUD
+    explicit FPSCounter(const std::vector<int>& windows = {120, 1200});
     
+    // Records the time since the last call and drains the ring
     void update();
+    
+    // Lock-free, callable from any thread
+    void recordFrameTime(double frame_ms);
+    
     double getFPS() const { return current_fps_; }
     double getAverageFPS() const;
     double getMinFPS() const;
     double getMaxFPS() const;
     
+    const FrameStats& getWindowStats(size_t window = 0) const { return windows_[window].stats; }
+    int getWindowSize(size_t window) const { return windows_[window].size; }
+    size_t getWindowCount() const { return windows_.size(); }
+    
+    // Session histogram, e.g. one auto-zoom run
+    void beginSession();
+    const FrameStats& getSessionStats() const { return session_.stats; }
+    
+    // Samples overwritten before update() could drain them
+    uint64_t getDroppedSamples() const { return dropped_samples_; }
+    
     std::string getStatsString() const;
     
     void reset();
-    
+
 private:
+    static const int RING_CAPACITY = 1024;
+    static const int SUB_BUCKET_BITS = 4;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int MAX_OCTAVE = 26; // 2^26 us, about a minute per frame
+    static const int BUCKET_COUNT = (MAX_OCTAVE - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+    
+    struct Slot {
+        std::atomic<uint64_t> sequence{0}; // Index + 1 once the value is written, 0 while writing
+        std::atomic<uint32_t> frame_us{0};
+    };
+    
+    struct Histogram {
+        int size = 0;                        // Window in frames, 0 for a session
+        std::array<uint32_t, BUCKET_COUNT> counts{};
+        uint64_t frames = 0;
+        uint64_t total_us = 0;
+        FrameStats stats;
+        
+        void add(int bucket, uint32_t frame_us);
+        void remove(int bucket, uint32_t frame_us);
+        void clear();
+        void updateStats();
+    };
+    
+    static int bucketOf(uint32_t frame_us);
+    static double bucketMidpointUs(int bucket);
+    
+    void drain();
+    
     std::chrono::high_resolution_clock::time_point last_time_;
-    std::deque<double> frame_times_;
     double current_fps_;
     
-    static const size_t MAX_SAMPLES = 60; // Keep last 60 frame times
+    std::array<Slot, RING_CAPACITY> ring_;
+    std::atomic<uint64_t> write_index_;
+    
+    // Render thread only
+    uint64_t read_index_;
+    uint64_t dropped_samples_;
+    std::vector<Histogram> windows_;
+    Histogram session_;
+    std::vector<uint32_t> history_; // Last frames for leaving the sliding windows
+    uint64_t history_count_;
 };
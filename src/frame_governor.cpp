@@ -0,0 +1,76 @@
+#include "frame_governor.h"
+#include <algorithm>
+#include <cmath>
+
+FrameGovernor::FrameGovernor(double budget_ms)
+    : enabled_(false), budget_ms_(budget_ms), scale_(1.0), iteration_factor_(1.0) {
+}
+
+void FrameGovernor::setEnabled(bool enabled) {
+    enabled_ = enabled;
+    reset();
+}
+
+void FrameGovernor::setBudget(double budget_ms) {
+    budget_ms_ = std::max(1.0, budget_ms);
+    budget_hits_.clear();
+}
+
+void FrameGovernor::recordFrame(double compute_ms) {
+    if (!enabled_ || compute_ms <= 0.0) return;
+    
+    budget_hits_.push_back(compute_ms <= budget_ms_);
+    if (budget_hits_.size() > MAX_SAMPLES) {
+        budget_hits_.pop_front();
+    }
+    
+    // Compute time grows with the pixel count, i.e. with scale squared.
+    // Only react outside a dead band so the resolution doesn't flicker.
+    double ratio = budget_ms_ / compute_ms;
+    if (ratio > 0.85 && ratio < 1.25) return;
+    
+    if (ratio <= 0.85) {
+        if (scale_ > MIN_SCALE) {
+            double target = scale_ * std::sqrt(ratio);
+            scale_ = std::max(MIN_SCALE, std::min(scale_ - SCALE_STEP, target));
+        } else {
+            iteration_factor_ = std::max(MIN_ITERATION_FACTOR, iteration_factor_ * std::max(0.5, ratio));
+        }
+    } else {
+        if (iteration_factor_ < 1.0) {
+            iteration_factor_ = std::min(1.0, iteration_factor_ * std::min(1.5, ratio));
+        } else {
+            // Grow one step at a time so a single fast frame can't overshoot
+            double target = scale_ * std::sqrt(ratio);
+            if (target > scale_ + 0.5 * SCALE_STEP) {
+                scale_ = std::min(1.0, scale_ + SCALE_STEP);
+            }
+        }
+    }
+    
+    // Quantize so the render resolution only takes a handful of values
+    scale_ = std::round(scale_ / SCALE_STEP) * SCALE_STEP;
+    scale_ = std::max(MIN_SCALE, std::min(1.0, scale_));
+}
+
+int FrameGovernor::getIterations(int base_iterations, double zoom) const {
+    if (!enabled_) return base_iterations;
+    
+    // Deeper zooms need more iterations to resolve the boundary
+    double depth = std::log2(std::max(1.0, zoom));
+    double iterations = (base_iterations + 32.0 * depth) * iteration_factor_;
+    return std::max(32, std::min(2048, static_cast<int>(iterations)));
+}
+
+double FrameGovernor::getHitRate() const {
+    if (budget_hits_.empty()) return 0.0;
+    
+    size_t hits = std::count(budget_hits_.begin(), budget_hits_.end(), true);
+    return static_cast<double>(hits) / budget_hits_.size();
+}
+
+void FrameGovernor::reset() {
+    scale_ = 1.0;
+    iteration_factor_ = 1.0;
+    budget_hits_.clear();
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <deque>
+#include <cstddef>
+
+// Keeps the fractal compute time of a frame inside a user-set budget by
+// lowering the internal render resolution (the renderer upscales it back to
+// the window size) and, once the resolution floor is reached, the iteration
+// limit. Iterations also follow the zoom depth so deep views keep detail.
+class FrameGovernor {
+public:
+    FrameGovernor(double budget_ms = 16.6);
+    
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled_; }
+    
+    void setBudget(double budget_ms);
+    double getBudget() const { return budget_ms_; }
+    
+    // Feed the measured compute time (calculation + colorizing) of one frame
+    void recordFrame(double compute_ms);
+    
+    double getScale() const { return enabled_ ? scale_ : 1.0; }
+    int getIterations(int base_iterations, double zoom) const;
+    double getHitRate() const;
+    
+    void reset();
+    
+private:
+    bool enabled_;
+    double budget_ms_;
+    double scale_;
+    double iteration_factor_;
+    std::deque<bool> budget_hits_;
+    
+    static constexpr double MIN_SCALE = 0.25;
+    static constexpr double SCALE_STEP = 0.05;
+    static constexpr double MIN_ITERATION_FACTOR = 0.25;
+    static const size_t MAX_SAMPLES = 120; // Hit rate over the last 120 frames
+};
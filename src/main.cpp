@@ -3,34 +3,102 @@
 #include <thread>
 #include <omp.h>
 #include <iomanip>
+#include <memory>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
 #include "mandelbrot.h"
 #include "renderer.h"
 #include "color_palette.h"
 #include "fps_counter.h"
+#include "frame_governor.h"
+#include "benchmark_runner.h"
+#include "benchmark_cache.h"
+#include "numa_topology.h"
+#include "tile_service.h"
+#include "tile_server.h"
+#include "zoom_prefetcher.h"
+#include <csignal>
+
+// Fork/join overhead and throughput of each threading runtime on the same scene
+void reportBackends(const std::vector<BackendResult>& backends) {
+    std::cout << "Parallel backends on " << getBackendComparisonScene().name << ":" << std::endl;
+    std::cout << std::left << std::setw(22) << "Backend" << std::right
+              << std::setw(16) << "Fork/join us" << std::setw(12) << "Frame ms"
+              << std::setw(12) << "Miter/s" << "  Checksum" << std::endl;
+    for (const auto& backend : backends) {
+        std::cout << std::left << std::setw(22) << ParallelBackend::getName(backend.type) << std::right << std::fixed
+                  << std::setw(16) << std::setprecision(1) << backend.fork_join_us
+                  << std::setw(12) << backend.frame_ms
+                  << std::setw(12) << backend.score
+                  << "  " << (backend.checksum_ok ? "OK" : "MISMATCH") << std::endl;
+    }
+}
+
+// Same scene on each node's CPUs alone, shows whether one socket is
+// slower (remote memory, thermal limits) than the others
+void reportNodes(const std::vector<NodeResult>& nodes) {
+    std::cout << "NUMA topology: " << NumaTopology::get().describe() << std::endl;
+    std::cout << std::left << std::setw(22) << "Node" << std::right
+              << std::setw(16) << "Threads" << std::setw(12) << "Frame ms"
+              << std::setw(12) << "Miter/s" << "  Checksum" << std::endl;
+    for (const auto& node : nodes) {
+        std::cout << std::left << std::setw(22) << ("node" + std::to_string(node.node)) << std::right << std::fixed
+                  << std::setw(16) << node.threads
+                  << std::setw(12) << std::setprecision(1) << node.frame_ms
+                  << std::setw(12) << node.score
+                  << "  " << (node.checksum_ok ? "OK" : "MISMATCH") << std::endl;
+    }
+}
 
 class MandelbrotApp {
 public:
-    MandelbrotApp() : 
-        params_{-0.5, 0.0, 1.0, 256, 800, 600},
-        calculator_(params_.width, params_.height),
+    MandelbrotApp(int width, int height, const AffinityConfig& affinity) : 
+        params_{-0.5, 0.0, 1.0, 256, width, height},
+        calculator_(params_.width, params_.height, ParallelBackend::OPENMP,
+                    static_cast<int>(std::thread::hardware_concurrency()), affinity),
         renderer_(params_.width, params_.height, "Almond Benchmark by JxThxNxs"),
         palette_(ColorPalette::CLASSIC),
         current_palette_type_(0),
         auto_zoom_(false),
         zoom_speed_(1.02),
+        needs_recalculate_(false),
+        frame_computed_(false),
+        frame_dirty_(false),
+        fused_pipeline_(true),
+        frame_fused_(false),
+        pipeline_ms_per_mpixel_{0.0, 0.0},
+        prefetch_enabled_(true),
+        frame_prefetched_(false),
+        zoom_session_fps_{0.0, 0.0},
+        zoom_session_paths_(0),
+        calc_time_ms_(0.0),
+        histogram_time_ms_(0.0),
         single_thread_time_(0.0),
         multi_thread_time_(0.0),
-        thread_count_(std::thread::hardware_concurrency()) {
+        thread_count_(std::thread::hardware_concurrency()),
+        affinity_(affinity),
+        almond_score_(0),
+        benchmark_cached_(false),
+        prefetcher_(thread_count_, affinity_) {
     }
     
     bool initialize() {
         if (!renderer_.initialize()) {
             return false;
         }
+        renderer_.placeBuffers(calculator_.getParallelBackend());
         
         std::cout << "Almond Benchmark by JxThxNxs" << std::endl;
+        std::cout << "Resolution: " << params_.width << "x" << params_.height << std::endl;
         std::cout << "Hardware threads: " << thread_count_ << std::endl;
         std::cout << "OpenMP threads: " << omp_get_max_threads() << std::endl;
+        std::cout << "NUMA topology: " << NumaTopology::get().describe() << std::endl;
+        std::cout << "Thread affinity: " << describeAffinity(affinity_) << std::endl;
         std::cout << "\nControls:" << std::endl;
         std::cout << "  Mouse: Click to zoom in at position" << std::endl;
         std::cout << "  WASD: Pan around" << std::endl;
@@ -39,12 +107,34 @@ public:
         std::cout << "  C: Change color palette" << std::endl;
         std::cout << "  Space: Toggle auto-zoom" << std::endl;
         std::cout << "  +/-: Increase/decrease iterations" << std::endl;
+        std::cout << "  G: Toggle frame-time governor" << std::endl;
+        std::cout << "  [/]: Decrease/increase governor frame budget" << std::endl;
+        std::cout << "  H: Toggle histogram-equalized coloring" << std::endl;
+        std::cout << "  F: Cycle precision (double / mixed float32 / mixed + verify)" << std::endl;
+        std::cout << "  P: Cycle parallel backend (OpenMP / std::thread pool / std::execution)" << std::endl;
+        std::cout << "  U: Toggle fused compute+colorize pipeline (auto-zoom frames)" << std::endl;
+        std::cout << "  O: Toggle resumable orbits (+/- continue or clamp instead of recomputing)" << std::endl;
+        std::cout << "  Z: Toggle speculative prefetch of upcoming auto-zoom frames" << std::endl;
         std::cout << "  B: Run benchmark" << std::endl;
         std::cout << "  ESC: Exit" << std::endl;
         
-        // Initial calculation
-        calculator_.calculateParallel(params_);
-        runBenchmark();
+        // Get a coarse first frame on screen right away, then the full
+        // resolution one before the suite starts taking turns for the cores
+        recalculate(PREVIEW_SCALE);
+        render();
+        recalculate();
+        
+        // Show the last score for this machine and build if there is one,
+        // otherwise measure in the background while the window is live
+        BenchmarkResult cached;
+        if (benchmark_cache_.load(BenchmarkCache::makeKey(thread_count_, affinity_), cached)) {
+            std::cout << "\nCached Almond Benchmark result (press B to re-run):" << std::endl;
+            applyBenchmarkResult(cached);
+            benchmark_cached_ = true;
+            reportBenchmark(cached);
+        } else {
+            runBenchmark();
+        }
         
         return true;
     }
@@ -52,12 +142,22 @@ public:
     void run() {
         while (renderer_.isRunning()) {
             handleEvents();
+            
+            // Frames that compute or colorize run between the suite's
+            // measured steps; HUD-only frames need no turn
+            const bool needs_cpus = needs_recalculate_ || auto_zoom_ || frame_dirty_;
+            if (needs_cpus) {
+                benchmark_runner_.beginForegroundFrame();
+            }
             update();
             render();
+            if (needs_cpus) {
+                benchmark_runner_.endForegroundFrame();
+            }
             fps_counter_.update();
         }
     }
-    
+
 private:
     void handleEvents() {
         while (renderer_.pollEvent()) {
@@ -67,16 +167,22 @@ private:
                 case SDL_QUIT:
                     renderer_.setRunning(false);
                     break;
-                    
+                
                 case SDL_KEYDOWN:
                     handleKeyPress(event.key.keysym.sym);
                     break;
-                    
+                
                 case SDL_MOUSEBUTTONDOWN:
                     if (event.button.button == SDL_BUTTON_LEFT) {
                         handleMouseClick(event.button.x, event.button.y);
                     }
                     break;
+                
+                case SDL_WINDOWEVENT:
+                    if (event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+                        handleResize(event.window.data1, event.window.data2);
+                    }
+                    break;
             }
         }
     }
@@ -88,37 +194,37 @@ private:
             case SDLK_ESCAPE:
                 renderer_.setRunning(false);
                 break;
-                
+            
             case SDLK_w:
                 params_.center_y -= 0.1 / params_.zoom;
                 recalculate = true;
                 break;
-                
+            
             case SDLK_s:
                 params_.center_y += 0.1 / params_.zoom;
                 recalculate = true;
                 break;
-                
+            
             case SDLK_a:
                 params_.center_x -= 0.1 / params_.zoom;
                 recalculate = true;
                 break;
-                
+            
             case SDLK_d:
                 params_.center_x += 0.1 / params_.zoom;
                 recalculate = true;
                 break;
-                
+            
             case SDLK_q:
                 params_.zoom /= 1.5;
                 recalculate = true;
                 break;
-                
+            
             case SDLK_e:
                 params_.zoom *= 1.5;
                 recalculate = true;
                 break;
-                
+            
             case SDLK_r:
                 params_.center_x = -0.5;
                 params_.center_y = 0.0;
@@ -126,37 +232,132 @@ private:
                 params_.max_iterations = 256;
                 recalculate = true;
                 break;
-                
+            
             case SDLK_c:
                 current_palette_type_ = (current_palette_type_ + 1) % 6;
                 palette_.setPaletteType(static_cast<ColorPalette::PaletteType>(current_palette_type_));
+                // No iterations left to recolor; queued prefetch frames are
+                // iteration counts and stay valid
+                if (frame_fused_) {
+                    needs_recalculate_ = true;
+                }
+                frame_dirty_ = true;
                 break;
-                
+            
             case SDLK_SPACE:
                 auto_zoom_ = !auto_zoom_;
                 std::cout << "Auto-zoom: " << (auto_zoom_ ? "ON" : "OFF") << std::endl;
-                break;
                 
+                // Each auto-zoom run is a frame-time session, so stutter
+                // while zooming shows up in p99 and 1% low
+                if (auto_zoom_) {
+                    fps_counter_.beginSession();
+                    prefetcher_.resetStats();
+                    zoom_session_paths_ = 0;
+                } else {
+                    prefetcher_.invalidate();
+                    zoom_session_stats_ = fps_counter_.getSessionStats();
+                    std::cout << "Auto-zoom frame times: " << zoom_session_stats_.toString() << std::endl;
+                    reportPrefetch();
+                }
+                break;
+            
             case SDLK_PLUS:
             case SDLK_EQUALS:
                 params_.max_iterations = std::min(2048, params_.max_iterations + 32);
                 recalculate = true;
                 std::cout << "Iterations: " << params_.max_iterations << std::endl;
                 break;
-                
+            
             case SDLK_MINUS:
                 params_.max_iterations = std::max(32, params_.max_iterations - 32);
                 recalculate = true;
                 std::cout << "Iterations: " << params_.max_iterations << std::endl;
                 break;
-                
+            
+            case SDLK_g:
+                governor_.setEnabled(!governor_.isEnabled());
+                recalculate = true;
+                std::cout << "Governor: " << (governor_.isEnabled() ? "ON" : "OFF")
+                          << " (budget " << governor_.getBudget() << " ms)" << std::endl;
+                break;
+            
+            case SDLK_LEFTBRACKET:
+            case SDLK_RIGHTBRACKET: {
+                static const double budgets[] = {8.3, 11.1, 16.6, 33.3, 50.0};
+                const int count = sizeof(budgets) / sizeof(budgets[0]);
+                int index = 0;
+                while (index < count - 1 && budgets[index] < governor_.getBudget() - 0.05) ++index;
+                index = (key == SDLK_LEFTBRACKET) ? std::max(0, index - 1) : std::min(count - 1, index + 1);
+                governor_.setBudget(budgets[index]);
+                std::cout << "Frame budget: " << governor_.getBudget() << " ms" << std::endl;
+                break;
+            }
+            
+            case SDLK_h:
+                palette_.setColoringMode(palette_.getColoringMode() == ColorPalette::LINEAR
+                                         ? ColorPalette::HISTOGRAM : ColorPalette::LINEAR);
+                recalculate = true;
+                std::cout << "Coloring: " << (palette_.getColoringMode() == ColorPalette::HISTOGRAM
+                                              ? "histogram equalized" : "linear") << std::endl;
+                break;
+            
+            case SDLK_f: {
+                static const MandelbrotCalculator::PrecisionMode modes[] = {
+                    MandelbrotCalculator::PrecisionMode::DOUBLE,
+                    MandelbrotCalculator::PrecisionMode::MIXED,
+                    MandelbrotCalculator::PrecisionMode::MIXED_VERIFY
+                };
+                int next = (static_cast<int>(calculator_.getPrecisionMode()) + 1) % 3;
+                calculator_.setPrecisionMode(modes[next]);
+                recalculate = true;
+                std::cout << "Precision: " << precisionModeName() << std::endl;
+                break;
+            }
+            
+            case SDLK_p: {
+                int next = calculator_.getParallelBackend().getType();
+                do {
+                    next = (next + 1) % ParallelBackend::BACKEND_COUNT;
+                } while (!ParallelBackend::isAvailable(static_cast<ParallelBackend::Type>(next)));
+                calculator_.setParallelBackend(static_cast<ParallelBackend::Type>(next), thread_count_, affinity_);
+                renderer_.placeBuffers(calculator_.getParallelBackend());
+                recalculate = true;
+                std::cout << "Parallel backend: " << ParallelBackend::getName(calculator_.getParallelBackend().getType())
+                          << " (" << calculator_.getParallelBackend().getThreadCount() << " threads)" << std::endl;
+                break;
+            }
+            
+            case SDLK_u:
+                fused_pipeline_ = !fused_pipeline_;
+                recalculate = true;
+                std::cout << "Fused pipeline: " << (fused_pipeline_ ? "ON" : "OFF") << std::endl;
+                break;
+            
+            case SDLK_o:
+                calculator_.setResumableOrbits(!calculator_.getResumableOrbits());
+                recalculate = true;
+                std::cout << "Resumable orbits: " << (calculator_.getResumableOrbits() ? "ON" : "OFF") << std::endl;
+                break;
+            
+            case SDLK_z:
+                prefetch_enabled_ = !prefetch_enabled_;
+                if (!prefetch_enabled_) {
+                    prefetcher_.invalidate();
+                }
+                std::cout << "Auto-zoom prefetch: " << (prefetch_enabled_ ? "ON" : "OFF") << std::endl;
+                break;
+            
             case SDLK_b:
                 runBenchmark();
                 break;
         }
         
+        // Every key that changes the view or how it is computed also
+        // leaves the predicted zoom path
         if (recalculate) {
-            calculator_.calculateParallel(params_);
+            needs_recalculate_ = true;
+            prefetcher_.invalidate();
         }
     }
     
@@ -172,82 +373,648 @@ private:
         params_.center_y = y_min + mouse_y * dy;
         params_.zoom *= 2.0;
         
-        calculator_.calculateParallel(params_);
+        needs_recalculate_ = true;
+        prefetcher_.invalidate();
+    }
+    
+    void handleResize(int width, int height) {
+        if (!renderer_.resize(width, height)) {
+            return;
+        }
+        
+        // The calculator reallocates on the next frame from the new params
+        params_.width = width;
+        params_.height = height;
+        renderer_.placeBuffers(calculator_.getParallelBackend());
+        governor_.reset();
+        needs_recalculate_ = true;
+        prefetcher_.invalidate();
     }
     
     void update() {
         if (auto_zoom_) {
             params_.zoom *= zoom_speed_;
-            calculator_.calculateParallel(params_);
+            needs_recalculate_ = true;
         }
+        
+        if (needs_recalculate_) {
+            needs_recalculate_ = false;
+            recalculate();
+        }
+        
+        pollBenchmark();
+    }
+    
+    void recalculate(double preview_scale = 0.0) {
+        // The governor picks the internal resolution and iteration limit;
+        // the renderer upscales the result to the window size
+        double scale = preview_scale > 0.0 ? preview_scale : governor_.getScale();
+        render_params_ = params_;
+        render_params_.width = std::max(1, static_cast<int>(params_.width * scale));
+        render_params_.height = std::max(1, static_cast<int>(params_.height * scale));
+        render_params_.max_iterations = governor_.getIterations(params_.max_iterations, params_.zoom);
+        
+        if (preview_scale <= 0.0 && auto_zoom_) {
+            zoom_session_paths_ |= framePath();
+        }
+        
+        // Auto-zoom frames may already be waiting in the prefetch queue
+        frame_prefetched_ = false;
+        if (preview_scale <= 0.0 && canPrefetch()) {
+            auto start = std::chrono::high_resolution_clock::now();
+            frame_prefetched_ = prefetcher_.take(render_params_, zoom_speed_, prefetched_iterations_);
+            auto end = std::chrono::high_resolution_clock::now();
+            
+            if (frame_prefetched_) {
+                calc_time_ms_ = std::chrono::duration<double, std::milli>(end - start).count();
+                frame_fused_ = false;
+                frame_computed_ = true;
+                frame_dirty_ = true;
+                return;
+            }
+        }
+        
+        // Fused frames are colorized as they are computed, so calc_time_ms_
+        // covers both and render() has nothing left to colorize
+        // The prefetch worker pauses meanwhile so the two teams do not share the cores
+        frame_fused_ = canFuse();
+        prefetcher_.setForegroundBusy(true);
+        auto start = std::chrono::high_resolution_clock::now();
+        if (frame_fused_) {
+            renderer_.renderMandelbrotFused(calculator_, render_params_, palette_);
+        } else {
+            calculator_.calculateParallel(render_params_);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        prefetcher_.setForegroundBusy(false);
+        
+        calc_time_ms_ = std::chrono::duration<double, std::milli>(end - start).count();
+        
+        if (!frame_fused_ && palette_.getColoringMode() == ColorPalette::HISTOGRAM) {
+            start = std::chrono::high_resolution_clock::now();
+            palette_.equalize(calculator_.computeHistogram(render_params_.max_iterations),
+                              render_params_.max_iterations);
+            end = std::chrono::high_resolution_clock::now();
+            
+            histogram_time_ms_ = std::chrono::duration<double, std::milli>(end - start).count();
+            calc_time_ms_ += histogram_time_ms_;
+        }
+        frame_computed_ = preview_scale <= 0.0;
+        frame_dirty_ = true;
+    }
+    
+    // Histogram coloring needs the whole frame's iterations before the first
+    // pixel can be colored, and the mixed precision paths and resumable
+    // orbits work on the iteration buffer, so they keep the three-pass
+    // pipeline. So do frames that stay on screen: keeping their iterations
+    // lets a palette change recolor without recomputing, which matters most
+    // at deep zoom. Auto-zoom replaces every frame, so there it fuses.
+    bool canFuse() const {
+        return fused_pipeline_ && auto_zoom_ && palette_.getColoringMode() == ColorPalette::LINEAR &&
+               calculator_.getPrecisionMode() == MandelbrotCalculator::PrecisionMode::DOUBLE &&
+               !calculator_.getResumableOrbits();
+    }
+    
+    // The prefetcher computes plain double frames at a known resolution and
+    // limit, so the governor, histogram coloring and mixed precision (which
+    // all depend on the frame just computed) switch it off
+    bool canPrefetch() const {
+        return prefetch_enabled_ && auto_zoom_ && !governor_.isEnabled() &&
+               palette_.getColoringMode() == ColorPalette::LINEAR &&
+               calculator_.getPrecisionMode() == MandelbrotCalculator::PrecisionMode::DOUBLE;
+    }
+    
+    // How an auto-zoom frame is produced, for crediting the session's FPS:
+    // through the prefetcher, or computed here in a mode the prefetcher
+    // could have served (so the two compare like for like), or neither
+    enum FramePath {
+        PATH_DIRECT = 1,
+        PATH_PREFETCH = 2,
+        PATH_OTHER = 4
+    };
+    
+    int framePath() const {
+        if (calculator_.getResumableOrbits()) return PATH_OTHER;
+        if (canPrefetch()) return PATH_PREFETCH;
+        
+        const bool eligible = !governor_.isEnabled() && palette_.getColoringMode() == ColorPalette::LINEAR &&
+                              calculator_.getPrecisionMode() == MandelbrotCalculator::PrecisionMode::DOUBLE;
+        return eligible ? PATH_DIRECT : PATH_OTHER;
     }
     
     void render() {
-        renderer_.clear();
-        renderer_.renderMandelbrot(calculator_.getIterations(), params_, palette_);
+        // The fractal covers every pixel, so the buffer is never cleared; a
+        // full-buffer fill from this thread would be remote writes for the
+        // other nodes' bands
+        // Only new frames and palette changes are colorized, the HUD is
+        // drawn over the unchanged pixel buffer on upload
+        double colorize_ms = 0.0;
+        if (!frame_fused_ && frame_dirty_) {
+            auto start = std::chrono::high_resolution_clock::now();
+            renderer_.renderMandelbrot(frame_prefetched_ ? prefetched_iterations_ : calculator_.getIterations(),
+                                       render_params_, palette_, calculator_.getParallelBackend());
+            auto end = std::chrono::high_resolution_clock::now();
+            colorize_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        }
+        frame_dirty_ = false;
+        
+        if (frame_computed_) {
+            governor_.recordFrame(calc_time_ms_ + colorize_ms);
+            recordPipelineCost(calc_time_ms_ + colorize_ms);
+            frame_computed_ = false;
+        }
+        
         renderer_.renderFPSCounter(fps_counter_);
-        renderer_.renderBenchmarkInfo(single_thread_time_, multi_thread_time_, thread_count_);
+        if (governor_.isEnabled()) {
+            renderer_.renderGovernorInfo(governor_.getScale(), governor_.getHitRate(),
+                                         governor_.getBudget(), render_params_.max_iterations);
+        }
+        if (palette_.getColoringMode() == ColorPalette::HISTOGRAM) {
+            renderer_.renderColoringInfo(histogram_time_ms_);
+        }
+        if (calculator_.getPrecisionMode() != MandelbrotCalculator::PrecisionMode::DOUBLE) {
+            renderer_.renderPrecisionInfo(precisionModeName(), calculator_.getPrecisionStats());
+        }
+        if (calculator_.getParallelBackend().getType() != ParallelBackend::OPENMP) {
+            renderer_.renderBackendInfo(ParallelBackend::getName(calculator_.getParallelBackend().getType()),
+                                        calculator_.getParallelBackend().getThreadCount(), calc_time_ms_);
+        }
+        if (fused_pipeline_) {
+            // The iteration buffer write and read-back this frame skipped
+            double skipped_mb = static_cast<double>(render_params_.width) * render_params_.height *
+                                2 * sizeof(int) / (1024.0 * 1024.0);
+            renderer_.renderPipelineInfo(frame_fused_, skipped_mb, pipeline_ms_per_mpixel_[1],
+                                         pipeline_ms_per_mpixel_[0]);
+        }
+        if (calculator_.getResumableOrbits() &&
+            calculator_.getPrecisionMode() == MandelbrotCalculator::PrecisionMode::DOUBLE) {
+            renderer_.renderOrbitInfo(calculator_.getOrbitStats());
+        }
+        if (canPrefetch()) {
+            ZoomPrefetcher::Stats stats = prefetcher_.getStats();
+            renderer_.renderPrefetchInfo(stats.getHitRate(), stats.getWaitRate(), stats.queued, prefetcher_.getDepth());
+        }
+        renderer_.renderBenchmarkInfo(single_thread_time_, multi_thread_time_, thread_count_, almond_score_);
+        if (benchmark_runner_.isRunning()) {
+            renderer_.renderBenchmarkProgress(benchmark_runner_.getProgress());
+        } else if (benchmark_cached_) {
+            renderer_.renderText("Cached result, B to re-run", 10, renderer_.getHeight() - 90, Color(160, 160, 160));
+        }
         renderer_.present();
     }
     
+    // Smoothed compute+colorize cost per megapixel of each pipeline, from
+    // frames either pipeline could have produced (plain double, linear
+    // coloring, computed here rather than prefetched)
+    void recordPipelineCost(double frame_ms) {
+        if (frame_prefetched_ || palette_.getColoringMode() != ColorPalette::LINEAR ||
+            calculator_.getPrecisionMode() != MandelbrotCalculator::PrecisionMode::DOUBLE ||
+            calculator_.getResumableOrbits()) {
+            return;
+        }
+        
+        double sample = frame_ms / (static_cast<double>(render_params_.width) * render_params_.height / 1e6);
+        double& average = pipeline_ms_per_mpixel_[frame_fused_];
+        average = average > 0.0 ? average * 0.9 + sample * 0.1 : sample;
+    }
+    
+    // Hit rate of the auto-zoom session that just ended, and its FPS against
+    // the last session run the other way
+    void reportPrefetch() {
+        // Only sessions that ran one way throughout are comparable
+        if (zoom_session_paths_ != PATH_DIRECT && zoom_session_paths_ != PATH_PREFETCH) {
+            if (zoom_session_paths_ != 0) {
+                std::cout << "Prefetch: session mixed modes, not used for the FPS comparison" << std::endl;
+            }
+            return;
+        }
+        
+        const bool prefetched = zoom_session_paths_ == PATH_PREFETCH;
+        zoom_session_fps_[prefetched] = zoom_session_stats_.average_ms > 0.0
+                                        ? 1000.0 / zoom_session_stats_.average_ms : 0.0;
+        
+        if (prefetched) {
+            ZoomPrefetcher::Stats stats = prefetcher_.getStats();
+            std::cout << "Prefetch: hit rate " << std::fixed << std::setprecision(1) << stats.getHitRate() * 100
+                      << "%, wait rate " << stats.getWaitRate() * 100 << "% (" << stats.hits << " queued, " << stats.waits << " in flight, "
+                      << stats.misses << " missed, " << stats.discarded << " discarded)" << std::endl;
+        }
+        if (zoom_session_fps_[0] > 0.0 && zoom_session_fps_[1] > 0.0) {
+            std::cout << "Prefetch FPS gain: " << std::fixed << std::setprecision(1)
+                      << (zoom_session_fps_[1] / zoom_session_fps_[0] - 1.0) * 100 << "% ("
+                      << zoom_session_fps_[1] << " vs " << zoom_session_fps_[0] << " FPS, last sessions)" << std::endl;
+        }
+    }
+    
+    const char* precisionModeName() const {
+        switch (calculator_.getPrecisionMode()) {
+            case MandelbrotCalculator::PrecisionMode::MIXED: return "mixed";
+            case MandelbrotCalculator::PrecisionMode::MIXED_VERIFY: return "mixed+verify";
+            default: return "double";
+        }
+    }
+    
     void runBenchmark() {
-        std::cout << "\nRunning Almond Benchmark..." << std::endl;
+        if (benchmark_runner_.isRunning()) {
+            std::cout << "Benchmark already running" << std::endl;
+            return;
+        }
         
-        MandelbrotParams bench_params = params_;
-        bench_params.max_iterations = 512; // Fixed iterations for consistent benchmarking
+        std::cout << "\nRunning Almond Benchmark suite v" << BENCHMARK_SUITE_VERSION
+                  << " in the background..." << std::endl;
         
-        // Single-threaded benchmark
-        omp_set_num_threads(1);
-        single_thread_time_ = calculator_.benchmarkSingle(bench_params, 3);
+        benchmark_cached_ = false;
+        benchmark_runner_.start(thread_count_, affinity_);
+    }
+    
+    void pollBenchmark() {
+        BenchmarkResult result;
+        if (!benchmark_runner_.takeResult(result)) {
+            return;
+        }
         
-        // Multi-threaded benchmark
-        omp_set_num_threads(thread_count_);
-        multi_thread_time_ = calculator_.benchmarkParallel(bench_params, 3);
+        applyBenchmarkResult(result);
+        reportBenchmark(result);
         
+        // A result with a wrong checksum measured something else, don't keep it
+        if (result.valid && !benchmark_cache_.store(BenchmarkCache::makeKey(thread_count_, affinity_), result)) {
+            std::cerr << "Could not write benchmark cache " << benchmark_cache_.getPath() << std::endl;
+        }
+    }
+    
+    void applyBenchmarkResult(const BenchmarkResult& result) {
+        single_thread_time_ = result.single_thread_ms;
+        multi_thread_time_ = result.multi_thread_ms;
+        almond_score_ = result.almond_score;
+    }
+    
+    void reportBenchmark(const BenchmarkResult& result) const {
         double speedup = single_thread_time_ / multi_thread_time_;
-        
-        // Calculate Almond Score (higher is better)
-        // Base score: 10000 / multi_thread_time (in ms)
-        // Bonus for good parallelization efficiency
         double efficiency = speedup / thread_count_;
-        double base_score = 10000.0 / multi_thread_time_;
-        double efficiency_bonus = efficiency * 1000.0;
-        almond_score_ = static_cast<int>(base_score + efficiency_bonus);
+        
+        if (!result.scenes.empty()) {
+            std::cout << std::left << std::setw(12) << "Scene" << std::right
+                      << std::setw(12) << "Single ms" << std::setw(12) << "Multi ms"
+                      << std::setw(12) << "Miter/s" << "  Checksum" << std::endl;
+            for (const auto& scene : result.scenes) {
+                std::cout << std::left << std::setw(12) << scene.name << std::right << std::fixed
+                          << std::setw(12) << std::setprecision(1) << scene.single_thread_ms
+                          << std::setw(12) << scene.multi_thread_ms
+                          << std::setw(12) << scene.score
+                          << "  " << (scene.checksum_ok ? "OK" : "MISMATCH") << std::endl;
+            }
+        }
+        
+        if (!result.backends.empty()) {
+            reportBackends(result.backends);
+        }
+        if (!result.nodes.empty()) {
+            reportNodes(result.nodes);
+        }
         
         std::cout << "Single-threaded: " << static_cast<int>(single_thread_time_) << " ms" << std::endl;
         std::cout << "Multi-threaded (" << thread_count_ << " threads): " << static_cast<int>(multi_thread_time_) << " ms" << std::endl;
         std::cout << "Speedup: " << std::fixed << std::setprecision(2) << speedup << "x" << std::endl;
         std::cout << "Efficiency: " << static_cast<int>(efficiency * 100) << "%" << std::endl;
-        std::cout << "ALMOND SCORE: " << almond_score_ << " points" << std::endl;
+        std::cout << "ALMOND SCORE: " << almond_score_ << " points (geometric mean of scene Miter/s)" << std::endl;
+        std::cout << "Rating: " << getAlmondRating(almond_score_) << std::endl;
         
-        // Score rating
-        std::string rating;
-        if (almond_score_ >= 500) rating = "EXCELLENT!";
-        else if (almond_score_ >= 300) rating = "VERY GOOD";
-        else if (almond_score_ >= 200) rating = "GOOD";
-        else if (almond_score_ >= 100) rating = "AVERAGE";
-        else rating = "NEEDS IMPROVEMENT";
+        if (!result.valid) {
+            std::cout << "WARNING: scene checksum mismatch, the score is not comparable" << std::endl;
+        }
         
-        std::cout << "Rating: " << rating << std::endl;
+        const size_t longest = fps_counter_.getWindowCount() - 1;
+        std::cout << "Frame times (last " << fps_counter_.getWindowSize(longest) << " frames): "
+                  << fps_counter_.getWindowStats(longest).toString() << std::endl;
+        if (zoom_session_stats_.frames > 0) {
+            std::cout << "Auto-zoom frame times (last session): " << zoom_session_stats_.toString() << std::endl;
+        }
     }
     
     MandelbrotParams params_;
+    MandelbrotParams render_params_;
     MandelbrotCalculator calculator_;
     Renderer renderer_;
     ColorPalette palette_;
     FPSCounter fps_counter_;
+    FrameStats zoom_session_stats_;
+    FrameGovernor governor_;
     
     int current_palette_type_;
     bool auto_zoom_;
     double zoom_speed_;
+    bool needs_recalculate_;
+    bool frame_computed_;
+    bool frame_dirty_;     // Pixel buffer needs colorizing
+    bool fused_pipeline_;
+    bool frame_fused_;     // Last frame went through the fused pipeline
+    double pipeline_ms_per_mpixel_[2]; // 3-pass, fused; 0 until measured
+    bool prefetch_enabled_;
+    bool frame_prefetched_; // Last frame came from the prefetch queue
+    IterationBuffer prefetched_iterations_;
+    double zoom_session_fps_[2]; // Average FPS of the last auto-zoom session without/with prefetch
+    int zoom_session_paths_;     // FramePath bits seen in the current auto-zoom session
+    double calc_time_ms_;
+    double histogram_time_ms_;
     double single_thread_time_;
     double multi_thread_time_;
     int thread_count_;
+    AffinityConfig affinity_;
     int almond_score_;
+    
+    BenchmarkRunner benchmark_runner_;
+    BenchmarkCache benchmark_cache_;
+    bool benchmark_cached_;
+    
+    ZoomPrefetcher prefetcher_;
+    
+    static constexpr double PREVIEW_SCALE = 0.25;
 };
 
-int main() {
-    MandelbrotApp app;
+// Measures throughput at increasing frame sizes to show where the iteration
+// and pixel buffers stop fitting in the caches, and what the fused pipeline
+// gains by never writing the iteration buffer
+void runResolutionBenchmark() {
+    static const int resolutions[][2] = {
+        {320, 240}, {640, 480}, {800, 600}, {1280, 720},
+        {1920, 1080}, {2560, 1440}, {3840, 2160}, {7680, 4320}
+    };
+    const int runs = 3;
+    
+    ColorPalette palette(ColorPalette::CLASSIC);
+    
+    std::cout << "Resolution scaling benchmark (" << omp_get_max_threads() << " threads)" << std::endl;
+    std::cout << std::setw(12) << "Resolution" << std::setw(12) << "Buffers"
+              << std::setw(12) << "Calc ms" << std::setw(12) << "Color ms"
+              << std::setw(12) << "Fused ms" << std::setw(12) << "Skipped"
+              << std::setw(12) << "Saved ms" << std::setw(12) << "Saved GB/s"
+              << std::setw(14) << "Mpixels/s" << std::setw(14) << "Fused Mpx/s" << std::endl;
+    
+    for (const auto& resolution : resolutions) {
+        MandelbrotParams params;
+        params.width = resolution[0];
+        params.height = resolution[1];
+        
+        MandelbrotCalculator calculator(params.width, params.height);
+        AlignedVector<uint32_t> pixels(params.width * params.height);
+        std::vector<uint32_t> lookup;
+        palette.buildLookup(params.max_iterations, lookup);
+        
+        calculator.calculateParallel(params); // Warm-up, faults in the pages
+        double calc_ms = calculator.benchmarkParallel(params, runs);
+        
+        // Colorized like Renderer::renderMandelbrot, one lookup per pixel
+        const IterationBuffer& iterations = calculator.getIterations();
+        const int pixel_count = params.width * params.height;
+        auto start = std::chrono::high_resolution_clock::now();
+        #pragma omp parallel for
+        for (int i = 0; i < pixel_count; ++i) {
+            pixels[i] = lookup[iterations[i]];
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        double color_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        
+        // Releases the iteration buffer, so it runs after the three-pass timing
+        calculator.calculateFused(params, lookup.data(), pixels.data(), params.width, params.height);
+        start = std::chrono::high_resolution_clock::now();
+        for (int run = 0; run < runs; ++run) {
+            calculator.calculateFused(params, lookup.data(), pixels.data(), params.width, params.height);
+        }
+        end = std::chrono::high_resolution_clock::now();
+        double fused_ms = std::chrono::duration<double, std::milli>(end - start).count() / runs;
+        
+        // Fusing skips writing the iteration buffer and reading it back. The
+        // time that saved is measured, and the skipped bytes over that time
+        // are the bandwidth the buffer pass was effectively costing (none
+        // shown when fusing was not faster)
+        double buffer_mb = pixel_count * (sizeof(int) + sizeof(uint32_t)) / (1024.0 * 1024.0);
+        double skipped_bytes = static_cast<double>(pixel_count) * 2 * sizeof(int);
+        double saved_ms = calc_ms + color_ms - fused_ms;
+        std::ostringstream saved_gbs;
+        if (saved_ms > 0.0) {
+            saved_gbs << std::fixed << std::setprecision(2) << skipped_bytes / (saved_ms * 1e6);
+        } else {
+            saved_gbs << "-";
+        }
+        double mpixels = pixel_count / ((calc_ms + color_ms) * 1000.0);
+        double fused_mpixels = pixel_count / (fused_ms * 1000.0);
+        
+        std::ostringstream name;
+        name << params.width << "x" << params.height;
+        std::cout << std::setw(12) << name.str()
+                  << std::setw(9) << std::fixed << std::setprecision(1) << buffer_mb << " MB"
+                  << std::setw(12) << std::setprecision(2) << calc_ms
+                  << std::setw(12) << color_ms
+                  << std::setw(12) << fused_ms
+                  << std::setw(9) << std::setprecision(1) << skipped_bytes / (1024.0 * 1024.0) << " MB"
+                  << std::setw(12) << std::setprecision(2) << saved_ms
+                  << std::setw(12) << saved_gbs.str()
+                  << std::setw(14) << mpixels
+                  << std::setw(14) << fused_mpixels << std::endl;
+    }
+}
+
+// Compares the threading runtimes on one scene without opening a window
+void runBackendBenchmark(const AffinityConfig& affinity) {
+    const int thread_count = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    std::vector<BackendResult> backends;
+    
+    for (int type = 0; type < ParallelBackend::BACKEND_COUNT; ++type) {
+        if (!ParallelBackend::isAvailable(static_cast<ParallelBackend::Type>(type))) {
+            std::cout << ParallelBackend::getName(static_cast<ParallelBackend::Type>(type))
+                      << ": not available in this build" << std::endl;
+            continue;
+        }
+        backends.push_back(measureBackend(static_cast<ParallelBackend::Type>(type), thread_count,
+                                          getBackendComparisonScene(), affinity));
+    }
+    
+    std::vector<NodeResult> nodes;
+    for (const auto& node : NumaTopology::get().getNodes()) {
+        nodes.push_back(measureNode(node, getBackendComparisonScene()));
+    }
+    
+    std::cout << "Threads: " << thread_count << ", affinity: " << describeAffinity(affinity) << std::endl;
+    reportBackends(backends);
+    reportNodes(nodes);
+}
+
+// Runs the same auto-zoom path with and without the prefetcher and no
+// window: each frame is computed (or taken from the queue), colorized and
+// copied out like a texture upload
+void runPrefetchBenchmark(const AffinityConfig& affinity) {
+    const int thread_count = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    const int frames = 120;
+    const double zoom_speed = 1.02;
+    const MandelbrotParams start = getBackendComparisonScene().params;
+    
+    ColorPalette palette(ColorPalette::CLASSIC);
+    std::vector<uint32_t> lookup;
+    palette.buildLookup(start.max_iterations, lookup);
+    
+    double fps[2] = {0.0, 0.0};
+    uint64_t checksum[2] = {0, 0};
+    ZoomPrefetcher::Stats stats;
+    
+    for (int prefetch = 0; prefetch < 2; ++prefetch) {
+        MandelbrotCalculator calculator(start.width, start.height, ParallelBackend::OPENMP, thread_count, affinity);
+        std::unique_ptr<ZoomPrefetcher> prefetcher;
+        if (prefetch) {
+            prefetcher.reset(new ZoomPrefetcher(thread_count, affinity));
+        }
+        
+        const int pixel_count = start.width * start.height;
+        AlignedVector<uint32_t> pixels(pixel_count);
+        AlignedVector<uint32_t> texture(pixel_count);
+        IterationBuffer prefetched;
+        MandelbrotParams params = start;
+        
+        auto begin = std::chrono::high_resolution_clock::now();
+        for (int frame = 0; frame < frames; ++frame) {
+            params.zoom *= zoom_speed;
+            const IterationBuffer* iterations = &prefetched;
+            if (!prefetcher) {
+                calculator.calculateParallel(params);
+                iterations = &calculator.getIterations();
+            } else if (!prefetcher->take(params, zoom_speed, prefetched)) {
+                prefetcher->setForegroundBusy(true);
+                calculator.calculateParallel(params);
+                prefetcher->setForegroundBusy(false);
+                iterations = &calculator.getIterations();
+            }
+            checksum[prefetch] = checksum[prefetch] * 31 + checksumIterations(*iterations);
+            
+            #pragma omp parallel for
+            for (int i = 0; i < pixel_count; ++i) {
+                pixels[i] = lookup[(*iterations)[i]];
+            }
+            std::memcpy(texture.data(), pixels.data(), pixel_count * sizeof(uint32_t));
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        
+        fps[prefetch] = frames / std::chrono::duration<double>(end - begin).count();
+        if (prefetcher) {
+            stats = prefetcher->getStats();
+        }
+    }
+    
+    std::cout << "Auto-zoom prefetch benchmark: " << frames << " frames of " << getBackendComparisonScene().name
+              << " at " << start.width << "x" << start.height << ", " << thread_count << " threads" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Without prefetch: " << fps[0] << " FPS" << std::endl;
+    std::cout << "With prefetch:    " << fps[1] << " FPS (hit rate " << stats.getHitRate() * 100 << "%, wait rate "
+              << stats.getWaitRate() * 100 << "%, " << stats.hits << " queued, " << stats.waits << " in flight, " << stats.misses << " missed)" << std::endl;
+    std::cout << "FPS gain: " << (fps[1] / fps[0] - 1.0) * 100 << "%" << std::endl;
+    std::cout << "Checksum: " << (checksum[0] == checksum[1] ? "OK" : "MISMATCH") << std::endl;
+}
+
+namespace {
+TileServer* g_tile_server = nullptr;
+
+void stopTileServer(int) {
+    if (g_tile_server) {
+        g_tile_server->stop();
+    }
+}
+}
+
+// Daemon mode: serve tiles over localhost HTTP or a Unix socket, no window
+int runTileService(int port, const std::string& socket_path, int queue_capacity, int batch_size) {
+    TileService service(queue_capacity, batch_size);
+    TileServer server(service);
+    
+    bool listening = socket_path.empty() ? server.listenTCP(port) : server.listenUnix(socket_path);
+    if (!listening) {
+        return 1;
+    }
+    
+    std::cout << "OpenMP threads: " << omp_get_max_threads()
+              << ", queue capacity: " << queue_capacity << ", batch size: " << batch_size << std::endl;
+    
+    g_tile_server = &server;
+    std::signal(SIGINT, stopTileServer);
+    std::signal(SIGTERM, stopTileServer);
+    
+    service.start();
+    server.run();
+    service.stop();
+    
+    g_tile_server = nullptr;
+    std::cout << "\n" << service.getStats();
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    int width = 800;
+    int height = 600;
+    bool serve = false;
+    int port = 8080;
+    std::string socket_path;
+    int queue_capacity = 256;
+    int batch_size = 8;
+    AffinityConfig affinity;
+    bool backend_benchmark = false;
+    bool prefetch_benchmark = false;
+    
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        
+        if (arg == "--resolution" && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+                std::cerr << "Invalid resolution '" << argv[i] << "', expected WIDTHxHEIGHT" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--resolution-benchmark") {
+            runResolutionBenchmark();
+            return 0;
+        } else if (arg == "--backend-benchmark") {
+            backend_benchmark = true;
+        } else if (arg == "--prefetch-benchmark") {
+            prefetch_benchmark = true;
+        } else if (arg == "--affinity" && i + 1 < argc) {
+            if (!parseAffinity(argv[++i], affinity)) {
+                std::cerr << "Invalid affinity '" << argv[i] << "', expected none, compact, scatter or a CPU list like 0,2,4-7" << std::endl;
+                return 1;
+            }
+            for (int cpu : affinity.cores) {
+                if (!NumaTopology::get().hasCpu(cpu)) {
+                    std::cerr << "CPU " << cpu << " is not available to this process" << std::endl;
+                    return 1;
+                }
+            }
+        } else if (arg == "--serve") {
+            serve = true;
+        } else if (arg == "--port" && i + 1 < argc) {
+            port = std::atoi(argv[++i]);
+        } else if (arg == "--socket" && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (arg == "--queue" && i + 1 < argc) {
+            queue_capacity = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--batch" && i + 1 < argc) {
+            batch_size = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--resolution WIDTHxHEIGHT] [--affinity none|compact|scatter|CPUS]\n"
+                      << "       " << argv[0] << " [--resolution-benchmark] [--backend-benchmark] [--prefetch-benchmark] [--affinity ...]\n"
+                      << "       " << argv[0] << " --serve [--port N | --socket PATH] [--queue N] [--batch N]" << std::endl;
+            return 1;
+        }
+    }
+    
+    if (backend_benchmark) {
+        runBackendBenchmark(affinity);
+        return 0;
+    }
+    
+    if (prefetch_benchmark) {
+        runPrefetchBenchmark(affinity);
+        return 0;
+    }
+    
+    if (serve) {
+        return runTileService(port, socket_path, queue_capacity, batch_size);
+    }
+    
+    MandelbrotApp app(width, height, affinity);
     
     if (!app.initialize()) {
         std::cerr << "Failed to initialize application" << std::endl;
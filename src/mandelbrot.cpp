@@ -2,15 +2,76 @@
 #include <chrono>
 #include <omp.h>
 #include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <mutex>
 
 MandelbrotCalculator::MandelbrotCalculator(int width, int height)
-    : width_(width), height_(height), iterations_(width * height) {
+    : MandelbrotCalculator(width, height, ParallelBackend::OPENMP, omp_get_max_threads()) {
+}
+
+MandelbrotCalculator::MandelbrotCalculator(int width, int height, ParallelBackend::Type type, int thread_count,
+                                           const AffinityConfig& affinity)
+    : width_(width), height_(height),
+      precision_mode_(PrecisionMode::DOUBLE), mixed_backoff_frames_(0),
+      resumable_orbits_(false), orbit_horizon_(0), orbit_frame_limit_(-1),
+      backend_(ParallelBackend::create(type, thread_count, affinity)) {
+    resize(width, height);
+}
+
+void MandelbrotCalculator::setParallelBackend(ParallelBackend::Type type, int thread_count,
+                                              const AffinityConfig& affinity) {
+    const AffinityConfig& current = backend_->getAffinity();
+    if (backend_->getType() == type && backend_->getThreadCount() == thread_count &&
+        current.policy == affinity.policy && current.cores == affinity.cores) {
+        return;
+    }
+    backend_.reset(); // A thread pool joins its workers before the next one starts
+    backend_ = ParallelBackend::create(type, thread_count, affinity);
+    
+    if (!iterations_.empty()) {
+        resize(width_, height_);
+    }
+    verify_iterations_.clear();
+}
+
+void MandelbrotCalculator::resize(int width, int height) {
+    width_ = width;
+    height_ = height;
+    // First touch from the threads that will compute each band
+    allocateFirstTouch(*backend_, iterations_, height, width, 0);
+    releaseOrbits();
+}
+
+void MandelbrotCalculator::setResumableOrbits(bool enabled) {
+    resumable_orbits_ = enabled;
+    if (!enabled) {
+        releaseOrbits();
+    }
+}
+
+void MandelbrotCalculator::swapIterations(IterationBuffer& spare) {
+    iterations_.swap(spare);
+    orbit_frame_limit_ = -1;
+}
+
+void MandelbrotCalculator::releaseOrbits() {
+    IterationBuffer().swap(escape_iterations_);
+    std::vector<OrbitState>().swap(orbits_);
+    orbit_horizon_ = 0;
+    orbit_frame_limit_ = -1;
 }
 
 int MandelbrotCalculator::mandelbrotIterations(std::complex<double> c, int max_iter) {
     std::complex<double> z(0.0, 0.0);
-    int iter = 0;
-    
+    return continueOrbit(c, z, 0, max_iter);
+}
+
+// Fresh and resumed orbits take exactly the same steps, so a resumed pixel
+// ends on the same iteration count as one computed from z = 0
+int MandelbrotCalculator::continueOrbit(std::complex<double> c, std::complex<double>& z, int iter, int max_iter) {
     while (iter < max_iter && std::norm(z) <= 4.0) {
         z = z * z + c;
         ++iter;
@@ -20,6 +81,11 @@ int MandelbrotCalculator::mandelbrotIterations(std::complex<double> c, int max_i
 }
 
 void MandelbrotCalculator::calculate(const MandelbrotParams& params) {
+    if (params.width != width_ || params.height != height_ ||
+        iterations_.size() != static_cast<size_t>(params.width) * params.height) {
+        resize(params.width, params.height);
+    }
+    
     double scale = 4.0 / params.zoom;
     double x_min = params.center_x - scale * 0.5;
     double y_min = params.center_y - scale * 0.5 * height_ / width_;
@@ -32,24 +98,369 @@ void MandelbrotCalculator::calculate(const MandelbrotParams& params) {
             iterations_[y * width_ + x] = mandelbrotIterations(c, params.max_iterations);
         }
     }
+    orbit_frame_limit_ = -1;
 }
 
 void MandelbrotCalculator::calculateParallel(const MandelbrotParams& params) {
+    if (params.width != width_ || params.height != height_ ||
+        iterations_.size() != static_cast<size_t>(params.width) * params.height) {
+        resize(params.width, params.height);
+    }
+    
+    if (precision_mode_ == PrecisionMode::DOUBLE && resumable_orbits_) {
+        calculateResumable(params);
+        return;
+    }
+    orbit_frame_limit_ = -1;
+    
+    if (precision_mode_ == PrecisionMode::DOUBLE) {
+        calculateParallelDouble(params, iterations_);
+        return;
+    }
+    
+    auto start = std::chrono::high_resolution_clock::now();
+    calculateMixed(params);
+    auto end = std::chrono::high_resolution_clock::now();
+    precision_stats_.mixed_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    precision_stats_.double_ms = 0.0;
+    precision_stats_.mismatches = -1;
+    
+    if (precision_mode_ == PrecisionMode::MIXED_VERIFY) {
+        if (verify_iterations_.size() != iterations_.size()) {
+            allocateFirstTouch(*backend_, verify_iterations_, height_, width_, 0);
+        }
+        
+        start = std::chrono::high_resolution_clock::now();
+        calculateParallelDouble(params, verify_iterations_);
+        end = std::chrono::high_resolution_clock::now();
+        precision_stats_.double_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        
+        std::atomic<int> mismatches(0);
+        backend_->parallelFor(height_, [&](int row_begin, int row_end) {
+            int chunk_mismatches = 0;
+            for (size_t i = static_cast<size_t>(row_begin) * width_; i < static_cast<size_t>(row_end) * width_; ++i) {
+                chunk_mismatches += iterations_[i] != verify_iterations_[i];
+            }
+            mismatches += chunk_mismatches;
+        });
+        precision_stats_.mismatches = mismatches.load();
+    }
+}
+
+void MandelbrotCalculator::calculateFused(const MandelbrotParams& params, const uint32_t* color_lookup,
+                                          uint32_t* pixels, int pixel_width, int pixel_height) {
+    IterationBuffer().swap(iterations_);
+    releaseOrbits();
+    
+    double scale = 4.0 / params.zoom;
+    double x_min = params.center_x - scale * 0.5;
+    double y_min = params.center_y - scale * 0.5 * params.height / params.width;
+    double dx = scale / params.width;
+    double dy = scale / params.width;
+    
+    const bool scaled = params.width != pixel_width || params.height != pixel_height;
+    std::vector<int> column_map;
+    if (scaled) {
+        column_map.resize(pixel_width);
+        for (int x = 0; x < pixel_width; ++x) {
+            column_map[x] = std::min(params.width - 1, x * params.width / pixel_width);
+        }
+    }
+    
+    // Rows are partitioned in window space like Renderer::renderMandelbrot,
+    // so the pixel pages stay with the threads placeBuffers touched them from
+    backend_->parallelFor(pixel_height, [&](int row_begin, int row_end) {
+        AlignedVector<uint32_t> scaled_row(scaled ? params.width : 0);
+        int last_src_y = -1;
+        
+        for (int y = row_begin; y < row_end; ++y) {
+            int src_y = scaled ? std::min(params.height - 1, y * params.height / pixel_height) : y;
+            uint32_t* dest = pixels + static_cast<size_t>(y) * pixel_width;
+            
+            if (src_y == last_src_y) {
+                std::memcpy(dest, dest - pixel_width, pixel_width * sizeof(uint32_t));
+                continue;
+            }
+            
+            uint32_t* row = scaled ? scaled_row.data() : dest;
+            for (int x = 0; x < params.width; ++x) {
+                std::complex<double> c(x_min + x * dx, y_min + src_y * dy);
+                row[x] = color_lookup[mandelbrotIterations(c, params.max_iterations)];
+            }
+            if (scaled) {
+                for (int x = 0; x < pixel_width; ++x) {
+                    dest[x] = scaled_row[column_map[x]];
+                }
+            }
+            last_src_y = src_y;
+        }
+    });
+}
+
+void MandelbrotCalculator::calculateParallelDouble(const MandelbrotParams& params, IterationBuffer& target) {
     double scale = 4.0 / params.zoom;
     double x_min = params.center_x - scale * 0.5;
     double y_min = params.center_y - scale * 0.5 * height_ / width_;
     double dx = scale / width_;
     double dy = scale / width_;
     
-    #pragma omp parallel for collapse(2)
-    for (int y = 0; y < height_; ++y) {
-        for (int x = 0; x < width_; ++x) {
+    backend_->parallelFor(height_, [&](int row_begin, int row_end) {
+        if (chunk_gate_ && !chunk_gate_()) return;
+        
+        for (int y = row_begin; y < row_end; ++y) {
+            for (int x = 0; x < width_; ++x) {
+                std::complex<double> c(x_min + x * dx, y_min + y * dy);
+                target[y * width_ + x] = mandelbrotIterations(c, params.max_iterations);
+            }
+        }
+    });
+}
+
+void MandelbrotCalculator::calculateResumable(const MandelbrotParams& params) {
+    auto start = std::chrono::high_resolution_clock::now();
+    
+    const bool same_view = orbit_horizon_ > 0 &&
+        params.center_x == orbit_view_.center_x && params.center_y == orbit_view_.center_y &&
+        params.zoom == orbit_view_.zoom && params.width == orbit_view_.width &&
+        params.height == orbit_view_.height;
+    
+    orbit_stats_ = OrbitStats();
+    if (!same_view) {
+        orbit_stats_.action = OrbitStats::COMPUTED;
+        captureOrbits(params);
+    } else if (params.max_iterations > orbit_horizon_) {
+        orbit_stats_.action = OrbitStats::RESUMED;
+        orbit_stats_.resumed_orbits = static_cast<int>(orbits_.size());
+        resumeOrbits(params);
+    } else {
+        orbit_stats_.action = OrbitStats::CLAMPED;
+        if (orbit_frame_limit_ != params.max_iterations) {
+            clampIterations(params.max_iterations);
+        }
+    }
+    orbit_frame_limit_ = params.max_iterations;
+    
+    auto end = std::chrono::high_resolution_clock::now();
+    orbit_stats_.stored_orbits = orbits_.size();
+    orbit_stats_.ms = std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void MandelbrotCalculator::captureOrbits(const MandelbrotParams& params) {
+    if (escape_iterations_.size() != iterations_.size()) {
+        allocateFirstTouch(*backend_, escape_iterations_, height_, width_, 0);
+    }
+    orbits_.clear();
+    std::mutex orbits_mutex;
+    
+    double scale = 4.0 / params.zoom;
+    double x_min = params.center_x - scale * 0.5;
+    double y_min = params.center_y - scale * 0.5 * height_ / width_;
+    double dx = scale / width_;
+    double dy = scale / width_;
+    
+    backend_->parallelFor(height_, [&](int row_begin, int row_end) {
+        std::vector<OrbitState> bounded;
+        for (int y = row_begin; y < row_end; ++y) {
+            for (int x = 0; x < width_; ++x) {
+                std::complex<double> c(x_min + x * dx, y_min + y * dy);
+                std::complex<double> z(0.0, 0.0);
+                int index = y * width_ + x;
+                int iter = continueOrbit(c, z, 0, params.max_iterations);
+                iterations_[index] = iter;
+                escape_iterations_[index] = iter;
+                if (iter == params.max_iterations) {
+                    bounded.push_back({z, index});
+                }
+            }
+        }
+        
+        // Order does not matter, every entry carries its pixel index
+        std::lock_guard<std::mutex> lock(orbits_mutex);
+        orbits_.insert(orbits_.end(), bounded.begin(), bounded.end());
+    });
+    
+    orbit_view_ = params;
+    orbit_horizon_ = params.max_iterations;
+}
+
+void MandelbrotCalculator::resumeOrbits(const MandelbrotParams& params) {
+    double scale = 4.0 / params.zoom;
+    double x_min = params.center_x - scale * 0.5;
+    double y_min = params.center_y - scale * 0.5 * height_ / width_;
+    double dx = scale / width_;
+    double dy = scale / width_;
+    
+    // iterations_ already matches the stored counts unless the last frame
+    // was clamped below the horizon, then only resumed pixels change
+    const bool in_place = orbit_frame_limit_ == orbit_horizon_;
+    const int horizon = orbit_horizon_;
+    OrbitState* orbits = orbits_.data();
+    
+    backend_->parallelFor(static_cast<int>(orbits_.size()), [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            OrbitState& orbit = orbits[i];
+            int x = orbit.index % width_;
+            int y = orbit.index / width_;
             std::complex<double> c(x_min + x * dx, y_min + y * dy);
-            iterations_[y * width_ + x] = mandelbrotIterations(c, params.max_iterations);
+            int iter = continueOrbit(c, orbit.z, horizon, params.max_iterations);
+            escape_iterations_[orbit.index] = iter;
+            if (in_place) {
+                iterations_[orbit.index] = iter;
+            }
+        }
+    });
+    
+    const int max_iter = params.max_iterations;
+    orbits_.erase(std::remove_if(orbits_.begin(), orbits_.end(), [&](const OrbitState& orbit) {
+        return escape_iterations_[orbit.index] < max_iter;
+    }), orbits_.end());
+    orbit_horizon_ = max_iter;
+    orbit_view_.max_iterations = max_iter;
+    
+    if (!in_place) {
+        clampIterations(max_iter);
+    }
+}
+
+void MandelbrotCalculator::clampIterations(int max_iterations) {
+    backend_->parallelFor(height_, [&](int row_begin, int row_end) {
+        for (int i = row_begin * width_; i < row_end * width_; ++i) {
+            iterations_[i] = std::min(escape_iterations_[i], max_iterations);
+        }
+    });
+}
+
+void MandelbrotCalculator::calculateMixed(const MandelbrotParams& params) {
+    double scale = 4.0 / params.zoom;
+    double x_min = params.center_x - scale * 0.5;
+    double y_min = params.center_y - scale * 0.5 * height_ / width_;
+    double dx = scale / width_;
+    double dy = scale / width_;
+    
+    // Once neighbouring pixels are less than a few float ulps apart the
+    // float frame is meaningless, so the whole frame goes to double
+    // (a view where most pixels needed recomputing also backs off for a
+    // few frames, the float pass would only add to the double cost)
+    double extent = std::max({std::abs(x_min), std::abs(x_min + scale),
+                              std::abs(y_min), std::abs(y_min + dy * height_)});
+    if (dx < extent * std::numeric_limits<float>::epsilon() * 16.0 || mixed_backoff_frames_ > 0) {
+        mixed_backoff_frames_ = std::max(0, mixed_backoff_frames_ - 1);
+        precision_stats_.float_path_used = false;
+        precision_stats_.recompute_fraction = 1.0;
+        calculateParallelDouble(params, iterations_);
+        return;
+    }
+    
+    const int max_iter = params.max_iterations;
+    const int lanes = FLOAT_LANES;
+    std::atomic<long long> recomputed(0);
+    
+    backend_->parallelFor(height_, [&](int row_begin, int row_end) {
+        long long chunk_recomputed = 0;
+        for (int y = row_begin; y < row_end; ++y) {
+            const double cy = y_min + y * dy;
+            
+            for (int x0 = 0; x0 < width_; x0 += lanes) {
+                float cr[FLOAT_LANES], ci[FLOAT_LANES], delta2[FLOAT_LANES];
+                float zr[FLOAT_LANES], zi[FLOAT_LANES], dr[FLOAT_LANES], di[FLOAT_LANES];
+                int iter[FLOAT_LANES], alive[FLOAT_LANES], unsafe[FLOAT_LANES];
+                
+                for (int l = 0; l < lanes; ++l) {
+                    cr[l] = static_cast<float>(x_min + (x0 + l) * dx);
+                    ci[l] = static_cast<float>(cy);
+                    // Rounding of c and of every step acts like a perturbation
+                    // of c of this size; dz/dc carries it to z
+                    float delta = std::numeric_limits<float>::epsilon() * 4.0f * (std::abs(cr[l]) + std::abs(ci[l]) + 4.0f);
+                    delta2[l] = delta * delta;
+                    zr[l] = zi[l] = dr[l] = di[l] = 0.0f;
+                    iter[l] = 0;
+                    alive[l] = x0 + l < width_;
+                    unsafe[l] = 0;
+                }
+                
+                // All lanes step in lockstep so the loop body vectorizes
+                for (int k = 0; k < max_iter; ++k) {
+                    int any_alive = 0;
+                    for (int l = 0; l < lanes; ++l) {
+                        float zr2 = zr[l] * zr[l];
+                        float zi2 = zi[l] * zi[l];
+                        float norm = zr2 + zi2;
+                        
+                        // The bailout test is unreliable when the float error
+                        // of |z|^2 (about 2|z| * |dz| * delta) reaches the
+                        // distance to the bailout radius. NaN/inf count as unsafe.
+                        float margin = norm - 4.0f;
+                        float error2 = 16.0f * (dr[l] * dr[l] + di[l] * di[l]) * delta2[l];
+                        unsafe[l] |= alive[l] & !(margin * margin > error2);
+                        
+                        int step = alive[l] & (norm <= 4.0f);
+                        float new_dr = 2.0f * (zr[l] * dr[l] - zi[l] * di[l]) + 1.0f;
+                        float new_di = 2.0f * (zr[l] * di[l] + zi[l] * dr[l]);
+                        float new_zi = 2.0f * zr[l] * zi[l] + ci[l];
+                        float new_zr = zr2 - zi2 + cr[l];
+                        
+                        zr[l] = step ? new_zr : zr[l];
+                        zi[l] = step ? new_zi : zi[l];
+                        dr[l] = step ? new_dr : dr[l];
+                        di[l] = step ? new_di : di[l];
+                        iter[l] += step;
+                        alive[l] = step;
+                        any_alive |= step;
+                    }
+                    if (!any_alive) break;
+                }
+                
+                for (int l = 0; l < lanes && x0 + l < width_; ++l) {
+                    int x = x0 + l;
+                    if (unsafe[l]) {
+                        std::complex<double> c(x_min + x * dx, cy);
+                        iterations_[y * width_ + x] = mandelbrotIterations(c, max_iter);
+                        ++chunk_recomputed;
+                    } else {
+                        iterations_[y * width_ + x] = iter[l];
+                    }
+                }
+            }
         }
+        recomputed += chunk_recomputed;
+    });
+    
+    precision_stats_.float_path_used = true;
+    precision_stats_.recompute_fraction = static_cast<double>(recomputed.load()) / (static_cast<double>(width_) * height_);
+    if (precision_stats_.recompute_fraction > MAX_RECOMPUTE_FRACTION) {
+        mixed_backoff_frames_ = MIXED_BACKOFF_FRAMES;
     }
 }
 
+const std::vector<uint32_t>& MandelbrotCalculator::computeHistogram(int max_iterations) {
+    const int bins = max_iterations + 1;
+    const int stride = (bins + 15) / 16 * 16; // Keep each thread's bins on their own cache lines
+    const int slots = backend_->getThreadCount();
+    
+    thread_histograms_.assign(static_cast<size_t>(slots) * stride, 0);
+    
+    backend_->parallelForSlots(height_, [&](int slot, int row_begin, int row_end) {
+        uint32_t* local = &thread_histograms_[static_cast<size_t>(slot) * stride];
+        for (size_t i = static_cast<size_t>(row_begin) * width_; i < static_cast<size_t>(row_end) * width_; ++i) {
+            ++local[std::min(iterations_[i], max_iterations)];
+        }
+    });
+    
+    // Reduce across threads, bin ranges in parallel
+    histogram_.resize(bins);
+    backend_->parallelFor(bins, [&](int bin_begin, int bin_end) {
+        for (int bin = bin_begin; bin < bin_end; ++bin) {
+            uint32_t total = 0;
+            for (int t = 0; t < slots; ++t) {
+                total += thread_histograms_[static_cast<size_t>(t) * stride + bin];
+            }
+            histogram_[bin] = total;
+        }
+    });
+    
+    return histogram_;
+}
+
 double MandelbrotCalculator::benchmarkSingle(const MandelbrotParams& params, int runs) {
     auto start = std::chrono::high_resolution_clock::now();
     
@@ -58,9 +469,9 @@ double MandelbrotCalculator::benchmarkSingle(const MandelbrotParams& params, int
     }
     
     auto end = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    std::chrono::duration<double, std::milli> duration = end - start;
     
-    return static_cast<double>(duration.count()) / runs;
+    return duration.count() / runs;
 }
 
 double MandelbrotCalculator::benchmarkParallel(const MandelbrotParams& params, int runs) {
@@ -71,7 +482,7 @@ double MandelbrotCalculator::benchmarkParallel(const MandelbrotParams& params, i
     }
     
     auto end = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    std::chrono::duration<double, std::milli> duration = end - start;
     
-    return static_cast<double>(duration.count()) / runs;
+    return duration.count() / runs;
 }
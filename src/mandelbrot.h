@@ -3,6 +3,12 @@
 #include <complex>
 #include <vector>
 #include <cstdint>
+#include <functional>
+#include <memory>
+#include "aligned_buffer.h"
+#include "parallel_backend.h"
+
+using IterationBuffer = AlignedVector<int>;
 
 struct MandelbrotParams {
     double center_x = -0.5;
@@ -15,21 +21,136 @@ struct MandelbrotParams {
 
 class MandelbrotCalculator {
 public:
+    // MIXED runs the frame in float first and recomputes in double only the
+    // pixels whose iteration count rounding could change; MIXED_VERIFY also
+    // computes the pure double frame and counts mismatches
+    enum class PrecisionMode {
+        DOUBLE,
+        MIXED,
+        MIXED_VERIFY
+    };
+    
+    struct PrecisionStats {
+        bool float_path_used = false;   // False when the pixel spacing is below float resolution
+        double recompute_fraction = 0.0;
+        double mixed_ms = 0.0;
+        double double_ms = 0.0;         // Verify mode only
+        int mismatches = -1;            // Verify mode only
+    };
+    
+    struct OrbitStats {
+        enum Action {
+            COMPUTED,   // Whole frame from z = 0 (new view or first frame)
+            RESUMED,    // Limit raised, bounded orbits continued from the old horizon
+            CLAMPED     // Limit at or below the horizon, nothing iterated
+        };
+        Action action = COMPUTED;
+        int resumed_orbits = 0;
+        size_t stored_orbits = 0;       // Side list entries after the frame
+        double ms = 0.0;
+    };
+    
     MandelbrotCalculator(int width, int height);
+    // Starts on the given backend instead of building the default OpenMP one
+    MandelbrotCalculator(int width, int height, ParallelBackend::Type type, int thread_count,
+                         const AffinityConfig& affinity = AffinityConfig());
+    
+    void resize(int width, int height);
     
     void calculate(const MandelbrotParams& params);
     void calculateParallel(const MandelbrotParams& params);
     
-    const std::vector<int>& getIterations() const { return iterations_; }
+    // Computes and colorizes each row band in one pass through
+    // color_lookup (see ColorPalette::buildLookup) and writes ARGB straight
+    // into pixels, nearest-neighbour upscaled when the pixel size differs
+    // from params. Iteration counts never reach memory: the iteration
+    // buffer is released and getIterations() stays empty until the next
+    // calculate or calculateParallel. Always runs in double precision.
+    void calculateFused(const MandelbrotParams& params, const uint32_t* color_lookup,
+                        uint32_t* pixels, int pixel_width, int pixel_height);
+    
+    void setPrecisionMode(PrecisionMode mode) { precision_mode_ = mode; }
+    PrecisionMode getPrecisionMode() const { return precision_mode_; }
+    const PrecisionStats& getPrecisionStats() const { return precision_stats_; }
+    
+    // Double precision frames keep every pixel's escape iteration up to the
+    // highest limit computed so far (the horizon) and z for the pixels still
+    // bounded there. While the view stays the same, raising max_iterations
+    // only continues those orbits and lowering it clamps the stored counts,
+    // with results identical to computing from z = 0.
+    void setResumableOrbits(bool enabled);
+    bool getResumableOrbits() const { return resumable_orbits_; }
+    const OrbitStats& getOrbitStats() const { return orbit_stats_; }
+    
+    // Runtime used by calculateParallel; defaults to OpenMP with
+    // omp_get_max_threads() unpinned threads. Switching re-places the
+    // iteration buffer so its pages follow the new thread placement.
+    void setParallelBackend(ParallelBackend::Type type, int thread_count,
+                            const AffinityConfig& affinity = AffinityConfig());
+    ParallelBackend& getParallelBackend() { return *backend_; }
+    const ParallelBackend& getParallelBackend() const { return *backend_; }
+    
+    // Called before each chunk of a double precision frame without
+    // resumable orbits, possibly from several threads at once. It may block
+    // to yield the CPUs; returning false skips the chunk, leaving the frame
+    // incomplete. Used to throttle background work.
+    using ChunkGate = std::function<bool()>;
+    void setChunkGate(ChunkGate gate) { chunk_gate_ = std::move(gate); }
+    
+    const IterationBuffer& getIterations() const { return iterations_; }
+    
+    // Exchanges the iteration buffer with spare, which may have any size
+    // (the next frame reallocates if it has to), so a finished frame can be
+    // kept without copying it
+    void swapIterations(IterationBuffer& spare);
+    
+    // Iteration histogram of the last frame (max_iterations + 1 bins), built
+    // from per-thread histograms merged in parallel
+    const std::vector<uint32_t>& computeHistogram(int max_iterations);
+    int getWidth() const { return width_; }
+    int getHeight() const { return height_; }
     
     // Benchmark methods
     double benchmarkSingle(const MandelbrotParams& params, int runs = 10);
     double benchmarkParallel(const MandelbrotParams& params, int runs = 10);
-    
+
 private:
+    struct OrbitState {
+        std::complex<double> z;
+        int index;
+    };
+    
     int mandelbrotIterations(std::complex<double> c, int max_iter);
+    static int continueOrbit(std::complex<double> c, std::complex<double>& z, int iter, int max_iter);
+    void calculateParallelDouble(const MandelbrotParams& params, IterationBuffer& target);
+    void calculateMixed(const MandelbrotParams& params);
+    void calculateResumable(const MandelbrotParams& params);
+    void captureOrbits(const MandelbrotParams& params);
+    void resumeOrbits(const MandelbrotParams& params);
+    void clampIterations(int max_iterations);
+    void releaseOrbits();
+    
+    static const int FLOAT_LANES = 8; // One AVX register of floats per step
+    static constexpr double MAX_RECOMPUTE_FRACTION = 0.2;
+    static const int MIXED_BACKOFF_FRAMES = 16;
     
     int width_;
     int height_;
-    std::vector<int> iterations_;
+    IterationBuffer iterations_;
+    IterationBuffer verify_iterations_;
+    std::vector<uint32_t> thread_histograms_; // One padded histogram per backend thread slot
+    std::vector<uint32_t> histogram_;
+    PrecisionMode precision_mode_;
+    PrecisionStats precision_stats_;
+    int mixed_backoff_frames_;
+    
+    bool resumable_orbits_;
+    MandelbrotParams orbit_view_;        // View the stored orbits belong to
+    IterationBuffer escape_iterations_;  // min(escape iteration, horizon)
+    std::vector<OrbitState> orbits_;     // Pixels still bounded at the horizon
+    int orbit_horizon_;                  // 0 when nothing is stored
+    int orbit_frame_limit_;              // Limit iterations_ holds, -1 if another path wrote it
+    OrbitStats orbit_stats_;
+    ChunkGate chunk_gate_;
+    std::unique_ptr<ParallelBackend> backend_;
 };
@@ -0,0 +1,272 @@
+#include "numa_topology.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace {
+thread_local int t_pinned_cpu = -1; // Set by pinCurrentThread, -1 when unpinned
+
+#ifdef _WIN32
+DWORD_PTR g_process_mask = 0;
+
+void saveProcessAffinity() {
+    DWORD_PTR system_mask = 0;
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &g_process_mask, &system_mask)) {
+        g_process_mask = 0;
+    }
+}
+
+bool isAllowedCpu(int cpu) {
+    return g_process_mask == 0 || (cpu < 64 && (g_process_mask >> cpu) & 1);
+}
+#elif defined(__linux__)
+cpu_set_t g_process_mask;
+bool g_process_mask_valid = false;
+
+void saveProcessAffinity() {
+    CPU_ZERO(&g_process_mask);
+    g_process_mask_valid = sched_getaffinity(0, sizeof(g_process_mask), &g_process_mask) == 0;
+}
+
+bool isAllowedCpu(int cpu) {
+    return !g_process_mask_valid || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &g_process_mask));
+}
+#else
+void saveProcessAffinity() {}
+bool isAllowedCpu(int) { return true; }
+#endif
+
+std::string readFirstLine(const std::string& path) {
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+std::string formatCpuList(const std::vector<int>& cpus) {
+    std::ostringstream oss;
+    for (size_t i = 0; i < cpus.size(); ) {
+        size_t run = i;
+        while (run + 1 < cpus.size() && cpus[run + 1] == cpus[run] + 1) ++run;
+        
+        if (i > 0) oss << ",";
+        oss << cpus[i];
+        if (run > i) oss << "-" << cpus[run];
+        i = run + 1;
+    }
+    return oss.str();
+}
+}
+
+std::vector<int> parseCpuList(const std::string& text) {
+    std::vector<int> cpus;
+    std::istringstream ranges(text);
+    std::string range;
+    
+    while (std::getline(ranges, range, ',')) {
+        int first = 0, last = 0;
+        char dash = 0;
+        std::istringstream values(range);
+        if (!(values >> first)) return {};
+        if (values >> dash) {
+            if (dash != '-' || !(values >> last) || last < first) return {};
+        } else {
+            last = first;
+        }
+        if (first < 0) return {};
+        
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+const NumaTopology& NumaTopology::get() {
+    static const NumaTopology topology;
+    return topology;
+}
+
+NumaTopology::NumaTopology() {
+    saveProcessAffinity();
+
+#ifdef __linux__
+    for (int id : parseCpuList(readFirstLine("/sys/devices/system/node/online"))) {
+        NumaNode node{id, {}};
+        std::ostringstream path;
+        path << "/sys/devices/system/node/node" << id << "/cpulist";
+        for (int cpu : parseCpuList(readFirstLine(path.str()))) {
+            if (isAllowedCpu(cpu)) node.cpus.push_back(cpu);
+        }
+        
+        // Memory-only nodes (CXL, HBM) have no CPUs to pin to
+        if (!node.cpus.empty()) {
+            nodes_.push_back(node);
+        }
+    }
+#endif
+
+    if (nodes_.empty()) {
+        NumaNode node{0, {}};
+        int cpu_count = std::max(1u, std::thread::hardware_concurrency());
+        for (int cpu = 0; cpu < cpu_count; ++cpu) {
+            if (isAllowedCpu(cpu)) node.cpus.push_back(cpu);
+        }
+        nodes_.push_back(node);
+    }
+}
+
+int NumaTopology::getCpuCount() const {
+    int count = 0;
+    for (const auto& node : nodes_) {
+        count += static_cast<int>(node.cpus.size());
+    }
+    return count;
+}
+
+int NumaTopology::getNodeOfCpu(int cpu) const {
+    for (const auto& node : nodes_) {
+        if (std::find(node.cpus.begin(), node.cpus.end(), cpu) != node.cpus.end()) {
+            return node.id;
+        }
+    }
+    return 0;
+}
+
+bool NumaTopology::hasCpu(int cpu) const {
+    for (const auto& node : nodes_) {
+        if (std::find(node.cpus.begin(), node.cpus.end(), cpu) != node.cpus.end()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string NumaTopology::describe() const {
+    std::ostringstream oss;
+    oss << nodes_.size() << (nodes_.size() == 1 ? " node" : " nodes");
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+        oss << (i == 0 ? " (" : ", ") << "node" << nodes_[i].id << ": cpus " << formatCpuList(nodes_[i].cpus);
+    }
+    oss << ")";
+    return oss.str();
+}
+
+bool parseAffinity(const std::string& text, AffinityConfig& config) {
+    AffinityConfig parsed;
+    if (text == "none") {
+        parsed.policy = AffinityPolicy::NONE;
+    } else if (text == "compact") {
+        parsed.policy = AffinityPolicy::COMPACT;
+    } else if (text == "scatter") {
+        parsed.policy = AffinityPolicy::SCATTER;
+    } else {
+        parsed.policy = AffinityPolicy::CORE_LIST;
+        parsed.cores = parseCpuList(text);
+        if (parsed.cores.empty()) return false;
+    }
+    
+    config = parsed;
+    return true;
+}
+
+std::string describeAffinity(const AffinityConfig& config) {
+    switch (config.policy) {
+        case AffinityPolicy::COMPACT: return "compact";
+        case AffinityPolicy::SCATTER: return "scatter";
+        case AffinityPolicy::CORE_LIST: return "cores " + formatCpuList(config.cores);
+        default: return "none";
+    }
+}
+
+std::vector<int> assignCpus(const AffinityConfig& config, int thread_count) {
+    std::vector<int> order;
+    const auto& nodes = NumaTopology::get().getNodes();
+    
+    switch (config.policy) {
+        case AffinityPolicy::NONE:
+            return {};
+        
+        case AffinityPolicy::COMPACT:
+            for (const auto& node : nodes) {
+                order.insert(order.end(), node.cpus.begin(), node.cpus.end());
+            }
+            break;
+        
+        case AffinityPolicy::SCATTER: {
+            size_t largest = 0;
+            for (const auto& node : nodes) {
+                largest = std::max(largest, node.cpus.size());
+            }
+            for (size_t i = 0; i < largest; ++i) {
+                for (const auto& node : nodes) {
+                    if (i < node.cpus.size()) order.push_back(node.cpus[i]);
+                }
+            }
+            break;
+        }
+        
+        case AffinityPolicy::CORE_LIST:
+            order = config.cores;
+            break;
+    }
+    
+    // More threads than CPUs wrap around and share
+    std::vector<int> cpus(thread_count);
+    for (int t = 0; t < thread_count; ++t) {
+        cpus[t] = order.empty() ? -1 : order[t % order.size()];
+    }
+    return cpus;
+}
+
+bool pinCurrentThread(int cpu) {
+    if (cpu < 0) return false;
+#ifdef _WIN32
+    if (cpu >= 64) return false;
+    bool pinned = SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << cpu) != 0;
+#elif defined(__linux__)
+    if (cpu >= CPU_SETSIZE) return false;
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    CPU_SET(cpu, &mask);
+    bool pinned = sched_setaffinity(0, sizeof(mask), &mask) == 0;
+#else
+    bool pinned = false;
+#endif
+    if (pinned) {
+        t_pinned_cpu = cpu;
+    }
+    return pinned;
+}
+
+void restoreThreadAffinity() {
+    NumaTopology::get(); // Make sure the start-up mask was saved
+#ifdef _WIN32
+    if (g_process_mask != 0) {
+        SetThreadAffinityMask(GetCurrentThread(), g_process_mask);
+    }
+#elif defined(__linux__)
+    if (g_process_mask_valid) {
+        sched_setaffinity(0, sizeof(g_process_mask), &g_process_mask);
+    }
+#endif
+    t_pinned_cpu = -1;
+}
+
+void applyThreadAffinity(int cpu) {
+    if (cpu == t_pinned_cpu) return;
+    
+    if (cpu >= 0) {
+        pinCurrentThread(cpu);
+    } else {
+        restoreThreadAffinity();
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+struct NumaNode {
+    int id;
+    std::vector<int> cpus; // Only CPUs this process may run on
+};
+
+// NUMA nodes and their CPUs as seen by this process, read once from
+// /sys/devices/system/node on Linux. Other platforms and kernels without
+// NUMA support report a single node holding every CPU.
+class NumaTopology {
+public:
+    static const NumaTopology& get();
+    
+    const std::vector<NumaNode>& getNodes() const { return nodes_; }
+    int getCpuCount() const;
+    int getNodeOfCpu(int cpu) const; // 0 for CPUs outside every node
+    bool hasCpu(int cpu) const;
+    
+    std::string describe() const;
+
+private:
+    NumaTopology();
+    
+    std::vector<NumaNode> nodes_;
+};
+
+// How worker threads are placed on CPUs. COMPACT fills one node before
+// the next, SCATTER deals threads round-robin across nodes, CORE_LIST
+// uses the given CPUs in order.
+enum class AffinityPolicy {
+    NONE,
+    COMPACT,
+    SCATTER,
+    CORE_LIST
+};
+
+struct AffinityConfig {
+    AffinityPolicy policy = AffinityPolicy::NONE;
+    std::vector<int> cores; // CORE_LIST only
+};
+
+// Accepts "none", "compact", "scatter" or a CPU list such as "0,2,8-15"
+bool parseAffinity(const std::string& text, AffinityConfig& config);
+std::string describeAffinity(const AffinityConfig& config);
+
+// CPU for each thread index, empty for AffinityPolicy::NONE
+std::vector<int> assignCpus(const AffinityConfig& config, int thread_count);
+
+// Pins the calling thread; restoreThreadAffinity undoes it by going back
+// to the CPU set the process started with
+bool pinCurrentThread(int cpu);
+void restoreThreadAffinity();
+
+// Pins the calling thread to cpu, or restores it for cpu < 0, unless the
+// last call on this thread already did so. Cheap enough to call at the
+// start of every parallel region.
+void applyThreadAffinity(int cpu);
+
+std::vector<int> parseCpuList(const std::string& text);
@@ -0,0 +1,273 @@
+#include "parallel_backend.h"
+#include <algorithm>
+#include <condition_variable>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <omp.h>
+
+#ifdef ALMOND_HAVE_STD_EXECUTION
+#include <execution>
+#endif
+
+namespace {
+
+void runChunk(const ParallelBackend::SlotRangeFunction& body, int slot, int begin, int end, int chunk, int chunks) {
+    int length = end - begin;
+    int chunk_begin = begin + static_cast<int>(static_cast<long long>(chunk) * length / chunks);
+    int chunk_end = begin + static_cast<int>(static_cast<long long>(chunk + 1) * length / chunks);
+    if (chunk_begin < chunk_end) {
+        body(slot, chunk_begin, chunk_end);
+    }
+}
+
+// Thread 0 is the calling thread, like the OpenMP master thread. The
+// runtime may hand a region different team threads than the last one
+// (another caller, a team of another size, a runtime that does not reuse
+// threads), so every region re-applies the affinity; threads already placed
+// skip the system call. An unpinned backend also unpins threads a pinned
+// one left behind.
+class OpenMPBackend : public ParallelBackend {
+public:
+    OpenMPBackend(int thread_count, const AffinityConfig& affinity)
+        : ParallelBackend(thread_count, affinity) {
+    }
+    
+    ~OpenMPBackend() override {
+        if (getThreadCpu(0) >= 0) {
+            #pragma omp parallel num_threads(thread_count_)
+            restoreThreadAffinity();
+        }
+    }
+    
+    Type getType() const override { return OPENMP; }
+    
+    void parallelForSlots(int count, const SlotRangeFunction& body) override {
+        prepareBands(count);
+        
+        #pragma omp parallel num_threads(thread_count_)
+        {
+            applyThreadAffinity(getThreadCpu(omp_get_thread_num()));
+            runBands(omp_get_thread_num(), body);
+        }
+    }
+};
+
+// Workers sleep on a condition variable between frames and are woken by a
+// generation counter; the calling thread takes chunks as well, so a pool of
+// N threads has N - 1 workers
+class ThreadPoolBackend : public ParallelBackend {
+public:
+    ThreadPoolBackend(int thread_count, const AffinityConfig& affinity)
+        : ParallelBackend(thread_count, affinity), stop_(false), generation_(0), pending_(0),
+          body_(nullptr) {
+        pinCurrentThread(getThreadCpu(0));
+        for (int i = 1; i < thread_count_; ++i) {
+            workers_.emplace_back(&ThreadPoolBackend::workerLoop, this, i);
+        }
+    }
+    
+    ~ThreadPoolBackend() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        start_cv_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+        if (getThreadCpu(0) >= 0) {
+            restoreThreadAffinity();
+        }
+    }
+    
+    Type getType() const override { return THREAD_POOL; }
+    
+    void parallelForSlots(int count, const SlotRangeFunction& body) override {
+        if (count <= 0) return;
+        
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            prepareBands(count);
+            body_ = &body;
+            pending_ = static_cast<int>(workers_.size());
+            ++generation_;
+        }
+        start_cv_.notify_all();
+        
+        // The calling thread may not be the one that built the pool
+        applyThreadAffinity(getThreadCpu(0));
+        runBands(0, body);
+        
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_cv_.wait(lock, [this] { return pending_ == 0; });
+        body_ = nullptr;
+    }
+
+private:
+    void workerLoop(int thread_index) {
+        pinCurrentThread(getThreadCpu(thread_index));
+        unsigned long long seen = 0;
+        
+        while (true) {
+            const SlotRangeFunction* body;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                start_cv_.wait(lock, [this, seen] { return stop_ || generation_ != seen; });
+                if (stop_) return;
+                seen = generation_;
+                body = body_;
+            }
+            
+            runBands(thread_index, *body);
+            
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--pending_ == 0) {
+                done_cv_.notify_one();
+            }
+        }
+    }
+    
+    std::vector<std::thread> workers_;
+    
+    std::mutex mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    bool stop_;
+    unsigned long long generation_;
+    int pending_;
+    const SlotRangeFunction* body_; // Current job, published under mutex_ before the generation bump
+};
+
+#ifdef ALMOND_HAVE_STD_EXECUTION
+// The standard library owns the threads (TBB's arena on libstdc++), so the
+// thread count only sizes the chunks and the threads cannot be pinned
+class StdExecutionBackend : public ParallelBackend {
+public:
+    explicit StdExecutionBackend(int thread_count)
+        : ParallelBackend(thread_count, AffinityConfig()) {}
+    
+    Type getType() const override { return STD_EXECUTION; }
+    
+    // One task per slot, each taking chunks until none are left, so a slot
+    // is never run by two threads at once
+    void parallelForSlots(int count, const SlotRangeFunction& body) override {
+        const int chunks = getChunkCount(count);
+        if (static_cast<int>(slot_ids_.size()) != thread_count_) {
+            slot_ids_.resize(thread_count_);
+            std::iota(slot_ids_.begin(), slot_ids_.end(), 0);
+        }
+        
+        std::atomic<int> next_chunk(0);
+        std::for_each(std::execution::par, slot_ids_.begin(), slot_ids_.end(), [&](int slot) {
+            int chunk;
+            while ((chunk = next_chunk.fetch_add(1, std::memory_order_relaxed)) < chunks) {
+                runChunk(body, slot, 0, count, chunk, chunks);
+            }
+        });
+    }
+
+private:
+    std::vector<int> slot_ids_;
+};
+#endif
+
+}
+
+ParallelBackend::ParallelBackend(int thread_count, const AffinityConfig& affinity)
+    : thread_count_(thread_count), affinity_(affinity),
+      thread_cpus_(assignCpus(affinity, thread_count)), band_count_(1) {
+    // One band per NUMA node the threads are pinned to, in node order
+    std::map<int, int> node_bands;
+    for (int cpu : thread_cpus_) {
+        node_bands[NumaTopology::get().getNodeOfCpu(cpu)] = 0;
+    }
+    int next_band = 0;
+    for (auto& node_band : node_bands) {
+        node_band.second = next_band++;
+    }
+    band_count_ = std::max(1, next_band);
+    
+    bands_.reset(new Band[band_count_]);
+    thread_band_.assign(thread_count_, 0);
+    for (int t = 0; t < thread_count_; ++t) {
+        if (!thread_cpus_.empty()) {
+            thread_band_[t] = node_bands[NumaTopology::get().getNodeOfCpu(thread_cpus_[t])];
+        }
+        ++bands_[thread_band_[t]].threads;
+    }
+}
+
+const char* ParallelBackend::getName(Type type) {
+    switch (type) {
+        case OPENMP: return "OpenMP";
+        case THREAD_POOL: return "std::thread pool";
+        case STD_EXECUTION: return "std::execution::par";
+        default: return "unknown";
+    }
+}
+
+bool ParallelBackend::isAvailable(Type type) {
+#ifndef ALMOND_HAVE_STD_EXECUTION
+    if (type == STD_EXECUTION) return false;
+#endif
+    return type >= OPENMP && type < BACKEND_COUNT;
+}
+
+std::unique_ptr<ParallelBackend> ParallelBackend::create(Type type, int thread_count, const AffinityConfig& affinity) {
+    thread_count = std::max(1, thread_count);
+    
+    switch (type) {
+        case THREAD_POOL:
+            return std::unique_ptr<ParallelBackend>(new ThreadPoolBackend(thread_count, affinity));
+#ifdef ALMOND_HAVE_STD_EXECUTION
+        case STD_EXECUTION:
+            if (affinity.policy != AffinityPolicy::NONE) {
+                std::cerr << "std::execution threads cannot be pinned, ignoring affinity" << std::endl;
+            }
+            return std::unique_ptr<ParallelBackend>(new StdExecutionBackend(thread_count));
+#endif
+        default:
+            return std::unique_ptr<ParallelBackend>(new OpenMPBackend(thread_count, affinity));
+    }
+}
+
+void ParallelBackend::parallelFor(int count, const RangeFunction& body) {
+    parallelForSlots(count, [&body](int, int begin, int end) { body(begin, end); });
+}
+
+int ParallelBackend::getChunkCount(int count) const {
+    return std::max(1, std::min(count, thread_count_ * CHUNKS_PER_THREAD));
+}
+
+int ParallelBackend::getThreadCpu(int thread_index) const {
+    return thread_cpus_.empty() ? -1 : thread_cpus_[thread_index % thread_cpus_.size()];
+}
+
+void ParallelBackend::prepareBands(int count) {
+    // Rows are shared out in proportion to each band's threads
+    int threads_before = 0;
+    for (int b = 0; b < band_count_; ++b) {
+        Band& band = bands_[b];
+        band.begin = static_cast<int>(static_cast<long long>(count) * threads_before / thread_count_);
+        threads_before += band.threads;
+        band.end = static_cast<int>(static_cast<long long>(count) * threads_before / thread_count_);
+        band.chunks = std::min(band.end - band.begin, band.threads * CHUNKS_PER_THREAD);
+        band.next_chunk.store(0, std::memory_order_relaxed);
+    }
+}
+
+void ParallelBackend::runBands(int thread_index, const SlotRangeFunction& body) {
+    const int home = thread_band_[thread_index % thread_count_];
+    
+    // Own node first, then help the others
+    for (int i = 0; i < band_count_; ++i) {
+        Band& band = bands_[(home + i) % band_count_];
+        int chunk;
+        while ((chunk = band.next_chunk.fetch_add(1, std::memory_order_relaxed)) < band.chunks) {
+            runChunk(body, thread_index, band.begin, band.end, chunk, band.chunks);
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "aligned_buffer.h"
+#include "numa_topology.h"
+
+// Threading runtime behind the calculator's parallel loops. Every backend
+// splits the rows into the same chunks (see getChunkCount) and hands them
+// out dynamically, so comparing backends measures the runtime, not the
+// partitioning.
+//
+// With thread affinity the rows are first cut into one contiguous band per
+// NUMA node, sized by the node's share of the threads. Threads take chunks
+// from their own node's band and only steal from other bands once it is
+// done, so buffers first-touched through parallelFor stay node-local.
+//
+// Pinning is applied by each parallelFor on the threads that run it. OpenMP
+// regions outside a backend (tile batches, the colorize loops of the
+// resolution and prefetch benchmarks) do not touch affinity and run with
+// whatever their team threads last had.
+class ParallelBackend {
+public:
+    enum Type {
+        OPENMP,
+        THREAD_POOL,     // Persistent std::thread workers
+        STD_EXECUTION,   // std::for_each(std::execution::par), TBB-backed on libstdc++
+        BACKEND_COUNT
+    };
+    
+    // Called once per chunk with a half-open row range
+    using RangeFunction = std::function<void(int begin, int end)>;
+    // Same, plus the slot in [0, getThreadCount()) of the worker running
+    // the chunk. Chunks with the same slot never run at the same time, so
+    // per-slot scratch needs no locking.
+    using SlotRangeFunction = std::function<void(int slot, int begin, int end)>;
+    
+    virtual ~ParallelBackend() = default;
+    
+    virtual Type getType() const = 0;
+    int getThreadCount() const { return thread_count_; }
+    
+    // NONE for backends that cannot pin their threads (std::execution)
+    const AffinityConfig& getAffinity() const { return affinity_; }
+    
+    // Returns once body has run for every chunk of [0, count)
+    void parallelFor(int count, const RangeFunction& body);
+    virtual void parallelForSlots(int count, const SlotRangeFunction& body) = 0;
+    
+    static const char* getName(Type type);
+    static bool isAvailable(Type type);
+    
+    // Falls back to OpenMP when the requested backend was not built in
+    static std::unique_ptr<ParallelBackend> create(Type type, int thread_count,
+                                                   const AffinityConfig& affinity = AffinityConfig());
+
+protected:
+    ParallelBackend(int thread_count, const AffinityConfig& affinity);
+    
+    int getChunkCount(int count) const;
+    
+    // Node band scheduling for backends that know their thread index
+    void prepareBands(int count);
+    void runBands(int thread_index, const SlotRangeFunction& body);
+    
+    int getThreadCpu(int thread_index) const;
+    
+    static const int CHUNKS_PER_THREAD = 8; // Enough to even out rows that hit the set
+    
+    int thread_count_;
+    AffinityConfig affinity_;
+
+private:
+    struct alignas(64) Band {
+        std::atomic<int> next_chunk{0};
+        int begin = 0;
+        int end = 0;
+        int chunks = 0;
+        int threads = 0;
+    };
+    
+    std::vector<int> thread_cpus_;  // Empty when not pinned
+    std::vector<int> thread_band_;
+    std::unique_ptr<Band[]> bands_;
+    int band_count_;
+};
+
+// Reallocates buffer for rows * row_size elements and writes value through
+// backend.parallelFor, so each page is first touched by a thread of the
+// node that computes those rows
+template <typename T>
+void allocateFirstTouch(ParallelBackend& backend, AlignedVector<T>& buffer, int rows, int row_size, T value) {
+    AlignedVector<T>().swap(buffer);
+    buffer.resize(static_cast<size_t>(rows) * row_size); // Default-initialized, no page is touched yet
+    
+    T* data = buffer.data();
+    backend.parallelFor(rows, [=](int row_begin, int row_end) {
+        std::fill(data + static_cast<size_t>(row_begin) * row_size,
+                  data + static_cast<size_t>(row_end) * row_size, value);
+    });
+}
@@ -0,0 +1,99 @@
+#include "png_writer.h"
+#include <algorithm>
+#include <array>
+
+namespace {
+
+std::array<uint32_t, 256> makeCRCTable() {
+    std::array<uint32_t, 256> table;
+    for (uint32_t n = 0; n < 256; ++n) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; ++k) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        table[n] = c;
+    }
+    return table;
+}
+
+uint32_t crc32(const uint8_t* data, size_t length) {
+    static const std::array<uint32_t, 256> table = makeCRCTable();
+    
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+uint32_t adler32(const uint8_t* data, size_t length) {
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < length; ++i) {
+        a = (a + data[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+}
+
+void writeU32(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void writeChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data) {
+    writeU32(out, static_cast<uint32_t>(data.size()));
+    size_t type_offset = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    writeU32(out, crc32(&out[type_offset], data.size() + 4));
+}
+
+} // namespace
+
+std::vector<uint8_t> encodePNG(const uint32_t* argb_pixels, int width, int height) {
+    // Scanlines with filter type 0 (none) in front of each row
+    std::vector<uint8_t> raw;
+    raw.reserve(static_cast<size_t>(height) * (width * 3 + 1));
+    for (int y = 0; y < height; ++y) {
+        raw.push_back(0);
+        for (int x = 0; x < width; ++x) {
+            uint32_t pixel = argb_pixels[y * width + x];
+            raw.push_back(static_cast<uint8_t>(pixel >> 16));
+            raw.push_back(static_cast<uint8_t>(pixel >> 8));
+            raw.push_back(static_cast<uint8_t>(pixel));
+        }
+    }
+    
+    // zlib header, stored blocks of at most 65535 bytes, Adler-32 trailer
+    std::vector<uint8_t> zlib = {0x78, 0x01};
+    size_t offset = 0;
+    do {
+        size_t block = std::min<size_t>(65535, raw.size() - offset);
+        bool final_block = offset + block == raw.size();
+        zlib.push_back(final_block ? 1 : 0);
+        zlib.push_back(static_cast<uint8_t>(block));
+        zlib.push_back(static_cast<uint8_t>(block >> 8));
+        zlib.push_back(static_cast<uint8_t>(~block));
+        zlib.push_back(static_cast<uint8_t>(~block >> 8));
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + block);
+        offset += block;
+    } while (offset < raw.size());
+    writeU32(zlib, adler32(raw.data(), raw.size()));
+    
+    std::vector<uint8_t> header;
+    writeU32(header, static_cast<uint32_t>(width));
+    writeU32(header, static_cast<uint32_t>(height));
+    header.push_back(8); // Bit depth
+    header.push_back(2); // Color type: RGB
+    header.push_back(0); // Compression
+    header.push_back(0); // Filter
+    header.push_back(0); // Interlace
+    
+    std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    writeChunk(png, "IHDR", header);
+    writeChunk(png, "IDAT", zlib);
+    writeChunk(png, "IEND", {});
+    return png;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+// Minimal PNG encoder for tiles: 8-bit RGB, zlib stream made of stored
+// (uncompressed) deflate blocks so no compression library is needed.
+// Input pixels are ARGB8888 as produced by the renderer.
+std::vector<uint8_t> encodePNG(const uint32_t* argb_pixels, int width, int height);
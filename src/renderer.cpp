@@ -1,11 +1,13 @@
 #include "renderer.h"
+#include "benchmark_runner.h"
 #include <iostream>
 #include <sstream>
 #include <cstring>
+#include <algorithm>
 
 Renderer::Renderer(int width, int height, const std::string& title)
     : window_(nullptr), sdl_renderer_(nullptr), texture_(nullptr),
-      width_(width), height_(height), running_(false), initialized_(false) {
+      target_(nullptr), target_pitch_(0), width_(width), height_(height), running_(false), initialized_(false) {
     pixel_buffer_.resize(width * height);
 }
 
@@ -21,7 +23,7 @@ bool Renderer::initialize() {
     
     window_ = SDL_CreateWindow("Almond Benchmark by JxThxNxs",
                               SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
-                              width_, height_, SDL_WINDOW_SHOWN);
+                              width_, height_, SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
     
     if (!window_) {
         std::cerr << "Window creation failed: " << SDL_GetError() << std::endl;
@@ -34,6 +36,20 @@ bool Renderer::initialize() {
         return false;
     }
     
+    if (!createTexture()) {
+        return false;
+    }
+    
+    running_ = true;
+    initialized_ = true;
+    return true;
+}
+
+bool Renderer::createTexture() {
+    if (texture_) {
+        SDL_DestroyTexture(texture_);
+    }
+    
     texture_ = SDL_CreateTexture(sdl_renderer_, SDL_PIXELFORMAT_ARGB8888,
                                 SDL_TEXTUREACCESS_STREAMING, width_, height_);
     
@@ -42,11 +58,25 @@ bool Renderer::initialize() {
         return false;
     }
     
-    running_ = true;
-    initialized_ = true;
     return true;
 }
 
+bool Renderer::resize(int width, int height) {
+    if (width <= 0 || height <= 0) return false;
+    if (width == width_ && height == height_) return true;
+    
+    width_ = width;
+    height_ = height;
+    AlignedVector<uint32_t>().swap(pixel_buffer_);
+    pixel_buffer_.resize(width * height);
+    
+    return !sdl_renderer_ || createTexture();
+}
+
+void Renderer::placeBuffers(ParallelBackend& backend) {
+    allocateFirstTouch(backend, pixel_buffer_, height_, width_, static_cast<uint32_t>(0xFF000000));
+}
+
 void Renderer::shutdown() {
     if (texture_) {
         SDL_DestroyTexture(texture_);
@@ -69,16 +99,32 @@ void Renderer::shutdown() {
     }
 }
 
-void Renderer::clear() {
-    std::fill(pixel_buffer_.begin(), pixel_buffer_.end(), 0xFF000000); // Black with alpha
-}
-
 void Renderer::present() {
     void* pixels;
     int pitch;
     
     SDL_LockTexture(texture_, nullptr, &pixels, &pitch);
-    std::memcpy(pixels, pixel_buffer_.data(), pixel_buffer_.size() * sizeof(uint32_t));
+    size_t row_bytes = width_ * sizeof(uint32_t);
+    if (static_cast<size_t>(pitch) == row_bytes) {
+        std::memcpy(pixels, pixel_buffer_.data(), pixel_buffer_.size() * sizeof(uint32_t));
+    } else {
+        // Texture rows may be padded for odd window widths
+        for (int y = 0; y < height_; ++y) {
+            std::memcpy(static_cast<uint8_t*>(pixels) + y * pitch, &pixel_buffer_[y * width_], row_bytes);
+        }
+    }
+    
+    target_ = static_cast<uint32_t*>(pixels);
+    target_pitch_ = pitch / static_cast<int>(sizeof(uint32_t));
+    for (const auto& item : overlay_) {
+        int current_x = item.x;
+        for (char c : item.text) {
+            renderChar(c, current_x, item.y, item.color);
+            current_x += 8; // Character width
+        }
+    }
+    overlay_.clear();
+    target_ = nullptr;
     SDL_UnlockTexture(texture_);
     
     SDL_RenderClear(sdl_renderer_);
@@ -87,20 +133,63 @@ void Renderer::present() {
 }
 
 void Renderer::setPixel(int x, int y, const Color& color) {
-    if (x >= 0 && x < width_ && y >= 0 && y < height_) {
+    if (target_ && x >= 0 && x < width_ && y >= 0 && y < height_) {
         uint32_t pixel = (color.a << 24) | (color.r << 16) | (color.g << 8) | color.b;
-        pixel_buffer_[y * width_ + x] = pixel;
+        target_[y * target_pitch_ + x] = pixel;
     }
 }
 
-void Renderer::renderMandelbrot(const std::vector<int>& iterations, const MandelbrotParams& params, const ColorPalette& palette) {
-    for (int y = 0; y < height_; ++y) {
-        for (int x = 0; x < width_; ++x) {
-            int iter = iterations[y * width_ + x];
-            Color color = palette.getColor(iter, params.max_iterations);
-            setPixel(x, y, color);
-        }
+void Renderer::renderMandelbrot(const IterationBuffer& iterations, const MandelbrotParams& params,
+                                const ColorPalette& palette, ParallelBackend& backend) {
+    palette.buildLookup(params.max_iterations, color_lookup_);
+    const uint32_t* lookup = color_lookup_.data();
+    
+    // Window rows are colorized with the same band partition the
+    // calculator used, so each thread writes node-local pixel pages
+    if (params.width == width_ && params.height == height_) {
+        backend.parallelFor(height_, [&](int row_begin, int row_end) {
+            for (int i = row_begin * width_; i < row_end * width_; ++i) {
+                pixel_buffer_[i] = lookup[iterations[i]];
+            }
+        });
+        return;
+    }
+    
+    // Reduced internal resolution: colorize each source row once and
+    // upscale it with nearest-neighbour sampling
+    column_map_.resize(width_);
+    for (int x = 0; x < width_; ++x) {
+        column_map_[x] = std::min(params.width - 1, x * params.width / width_);
     }
+    
+    backend.parallelFor(height_, [&](int row_begin, int row_end) {
+        AlignedVector<uint32_t> scaled_row(params.width);
+        int last_src_y = -1;
+        
+        for (int y = row_begin; y < row_end; ++y) {
+            int src_y = std::min(params.height - 1, y * params.height / height_);
+            uint32_t* dest = &pixel_buffer_[y * width_];
+            
+            if (src_y == last_src_y) {
+                std::memcpy(dest, dest - width_, width_ * sizeof(uint32_t));
+                continue;
+            }
+            
+            for (int x = 0; x < params.width; ++x) {
+                scaled_row[x] = lookup[iterations[src_y * params.width + x]];
+            }
+            for (int x = 0; x < width_; ++x) {
+                dest[x] = scaled_row[column_map_[x]];
+            }
+            last_src_y = src_y;
+        }
+    });
+}
+
+void Renderer::renderMandelbrotFused(MandelbrotCalculator& calculator, const MandelbrotParams& params,
+                                     const ColorPalette& palette) {
+    palette.buildLookup(params.max_iterations, color_lookup_);
+    calculator.calculateFused(params, color_lookup_.data(), pixel_buffer_.data(), width_, height_);
 }
 
 void Renderer::renderChar(char c, int x, int y, const Color& color) {
@@ -258,11 +347,7 @@ void Renderer::renderChar(char c, int x, int y, const Color& color) {
 }
 
 void Renderer::renderText(const std::string& text, int x, int y, Color color) {
-    int current_x = x;
-    for (char c : text) {
-        renderChar(c, current_x, y, color);
-        current_x += 8; // Character width
-    }
+    overlay_.push_back({text, x, y, color});
 }
 
 void Renderer::renderFPSCounter(const FPSCounter& fps_counter) {
@@ -270,7 +355,85 @@ void Renderer::renderFPSCounter(const FPSCounter& fps_counter) {
     renderText(fps_text, 10, 10, Color(255, 255, 0)); // Yellow text
 }
 
-void Renderer::renderBenchmarkInfo(double single_thread_time, double multi_thread_time, int thread_count) {
+void Renderer::renderGovernorInfo(double scale, double hit_rate, double budget_ms, int iterations) {
+    std::ostringstream oss;
+    oss << "Governor: " << static_cast<int>(scale * 100) << "% res | Budget "
+        << static_cast<int>(budget_ms * 10) / 10.0 << "ms | Hit "
+        << static_cast<int>(hit_rate * 100) << "% | Iter " << iterations;
+    renderText(oss.str(), 10, 25, Color(0, 255, 255)); // Cyan text
+}
+
+void Renderer::renderColoringInfo(double histogram_ms) {
+    std::ostringstream oss;
+    oss << "Histogram EQ: " << static_cast<int>(histogram_ms * 100) / 100.0 << "ms/frame";
+    renderText(oss.str(), 10, 55, Color(128, 255, 128)); // Light green text
+}
+
+void Renderer::renderPrecisionInfo(const std::string& mode, const MandelbrotCalculator::PrecisionStats& stats) {
+    std::ostringstream oss;
+    oss << "Precision: " << mode;
+    if (!stats.float_path_used) {
+        oss << " (double fallback)";
+    } else {
+        oss << " | Recompute " << static_cast<int>(stats.recompute_fraction * 1000) / 10.0 << "%";
+    }
+    oss << " | " << static_cast<int>(stats.mixed_ms * 10) / 10.0 << "ms";
+    
+    if (stats.mismatches >= 0 && stats.mixed_ms > 0.0) {
+        oss << " | Speedup " << static_cast<int>(stats.double_ms / stats.mixed_ms * 100) / 100.0
+            << "x | Mismatch " << stats.mismatches;
+    }
+    renderText(oss.str(), 10, 40, Color(255, 128, 255)); // Magenta text
+}
+
+void Renderer::renderBackendInfo(const std::string& backend, int thread_count, double compute_ms) {
+    std::ostringstream oss;
+    oss << "Backend: " << backend << " (" << thread_count << ") | "
+        << static_cast<int>(compute_ms * 10) / 10.0 << "ms";
+    renderText(oss.str(), 10, 70, Color(255, 200, 128)); // Light orange text
+}
+
+void Renderer::renderPipelineInfo(bool fused, double skipped_mb, double fused_ms_per_mpixel,
+                                  double three_pass_ms_per_mpixel) {
+    std::ostringstream oss;
+    if (fused) {
+        oss << "Pipeline: fused | skips " << static_cast<int>(skipped_mb * 10) / 10.0 << " MB/frame";
+    } else {
+        oss << "Pipeline: 3-pass (iteration buffer kept)";
+    }
+    if (fused_ms_per_mpixel > 0.0 && three_pass_ms_per_mpixel > 0.0) {
+        oss << " | " << static_cast<int>(fused_ms_per_mpixel * 100) / 100.0 << " vs "
+            << static_cast<int>(three_pass_ms_per_mpixel * 100) / 100.0 << " ms/Mpx";
+    }
+    renderText(oss.str(), 10, 85, Color(200, 200, 255)); // Lavender text
+}
+
+void Renderer::renderOrbitInfo(const MandelbrotCalculator::OrbitStats& stats) {
+    static const char* const actions[] = {"computed", "resumed", "clamped"};
+    std::ostringstream oss;
+    oss << "Orbits: " << actions[stats.action];
+    if (stats.action == MandelbrotCalculator::OrbitStats::RESUMED) {
+        oss << " " << stats.resumed_orbits;
+    }
+    oss << " | " << stats.stored_orbits << " bounded | "
+        << static_cast<int>(stats.ms * 10) / 10.0 << "ms";
+    renderText(oss.str(), 10, 100, Color(255, 255, 160)); // Pale yellow text
+}
+
+void Renderer::renderPrefetchInfo(double hit_rate, double wait_rate, size_t queued, int depth) {
+    std::ostringstream oss;
+    oss << "Prefetch: hit " << static_cast<int>(hit_rate * 100) << "% wait " << static_cast<int>(wait_rate * 100)
+        << "% | queue " << queued << "/" << depth;
+    renderText(oss.str(), 10, 115, Color(160, 255, 255)); // Pale cyan text
+}
+
+void Renderer::renderBenchmarkProgress(double progress) {
+    std::ostringstream oss;
+    oss << "Benchmark running: " << static_cast<int>(progress * 100) << "%";
+    renderText(oss.str(), 10, height_ - 90, Color(255, 165, 0)); // Orange text
+}
+
+void Renderer::renderBenchmarkInfo(double single_thread_time, double multi_thread_time, int thread_count, int almond_score) {
     std::ostringstream oss;
     
     // Show benchmark results
@@ -287,23 +450,12 @@ void Renderer::renderBenchmarkInfo(double single_thread_time, double multi_threa
         oss << "Speedup: " << static_cast<int>(speedup * 100) / 100.0 << "x";
         renderText(oss.str(), 10, height_ - 45, Color(0, 255, 0));
         
-        // Calculate and show Almond Score
-        double efficiency = speedup / thread_count;
-        double base_score = 10000.0 / multi_thread_time;
-        double efficiency_bonus = efficiency * 1000.0;
-        int almond_score = static_cast<int>(base_score + efficiency_bonus);
-        
         oss.str("");
         oss << "ALMOND SCORE: " << almond_score;
         renderText(oss.str(), 10, height_ - 30, Color(255, 215, 0)); // Gold color
         
         // Show rating
-        std::string rating;
-        if (almond_score >= 500) rating = "EXCELLENT!";
-        else if (almond_score >= 300) rating = "VERY GOOD";
-        else if (almond_score >= 200) rating = "GOOD";
-        else if (almond_score >= 100) rating = "AVERAGE";
-        else rating = "POOR";
+        std::string rating = getAlmondRating(almond_score);
         
         renderText(rating, 10, height_ - 15, Color(255, 100, 255)); // Pink color
     }
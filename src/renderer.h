@@ -15,13 +15,39 @@ public:
     bool initialize();
     void shutdown();
     
-    void clear();
+    // Reallocates the pixel buffer and texture, e.g. after a window resize.
+    // The pixel contents are undefined until placeBuffers or the next
+    // renderMandelbrot or renderMandelbrotFused.
+    bool resize(int width, int height);
+    
+    // First-touches the pixel buffer with the backend's row partition so
+    // each band lives on the node of the threads that colorize it
+    void placeBuffers(ParallelBackend& backend);
+    
     void present();
     
-    void renderMandelbrot(const std::vector<int>& iterations, const MandelbrotParams& params, const ColorPalette& palette);
+    void renderMandelbrot(const IterationBuffer& iterations, const MandelbrotParams& params,
+                          const ColorPalette& palette, ParallelBackend& backend);
+    
+    // Fused pipeline: the calculator colorizes each band as it computes it
+    // and writes the pixel buffer directly, no iteration buffer in between
+    void renderMandelbrotFused(MandelbrotCalculator& calculator, const MandelbrotParams& params,
+                               const ColorPalette& palette);
+    
+    // Text is queued and drawn over the frame when present() uploads it, so
+    // the pixel buffer only ever holds the fractal
     void renderText(const std::string& text, int x, int y, Color color = Color(255, 255, 255));
     void renderFPSCounter(const FPSCounter& fps_counter);
-    void renderBenchmarkInfo(double single_thread_time, double multi_thread_time, int thread_count);
+    void renderGovernorInfo(double scale, double hit_rate, double budget_ms, int iterations);
+    void renderColoringInfo(double histogram_ms);
+    void renderPrecisionInfo(const std::string& mode, const MandelbrotCalculator::PrecisionStats& stats);
+    void renderBackendInfo(const std::string& backend, int thread_count, double compute_ms);
+    // Per-megapixel costs are measured, 0 when not measured yet
+    void renderPipelineInfo(bool fused, double skipped_mb, double fused_ms_per_mpixel, double three_pass_ms_per_mpixel);
+    void renderOrbitInfo(const MandelbrotCalculator::OrbitStats& stats);
+    void renderPrefetchInfo(double hit_rate, double wait_rate, size_t queued, int depth);
+    void renderBenchmarkProgress(double progress);
+    void renderBenchmarkInfo(double single_thread_time, double multi_thread_time, int thread_count, int almond_score);
     
     bool isRunning() const { return running_; }
     void setRunning(bool running) { running_ = running; }
@@ -33,15 +59,30 @@ public:
     int getHeight() const { return height_; }
     
 private:
+    bool createTexture();
     void setPixel(int x, int y, const Color& color);
     void renderChar(char c, int x, int y, const Color& color);
     
+    struct OverlayText {
+        std::string text;
+        int x;
+        int y;
+        Color color;
+    };
+    
     SDL_Window* window_;
     SDL_Renderer* sdl_renderer_;
     SDL_Texture* texture_;
     SDL_Event event_;
     
-    std::vector<uint32_t> pixel_buffer_;
+    AlignedVector<uint32_t> pixel_buffer_;
+    std::vector<int> column_map_;
+    std::vector<uint32_t> color_lookup_;
+    std::vector<OverlayText> overlay_;
+    
+    // Locked texture while present() draws the overlay
+    uint32_t* target_;
+    int target_pitch_; // In pixels
     
     int width_;
     int height_;
@@ -0,0 +1,187 @@
+// Load-test client for the tile service (mandelbrot_benchmark --serve)
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+
+int main() {
+    std::cerr << "The tile client is not supported on Windows" << std::endl;
+    return 1;
+}
+
+#else
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+struct ClientOptions {
+    int port = 8080;
+    std::string socket_path;
+    int connections = 8;
+    int requests = 1000;
+    int max_level = 4;
+    int iterations = 256;
+    std::string format = "png";
+};
+
+int connectToServer(const ClientOptions& options) {
+    if (!options.socket_path.empty()) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, options.socket_path.c_str(), sizeof(address.sun_path) - 1);
+        if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) return fd;
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(options.port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd >= 0 && connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) return fd;
+    if (fd >= 0) close(fd);
+    return -1;
+}
+
+// Sends one GET and returns the HTTP status (or -1), body in 'body'
+int httpGet(const ClientOptions& options, const std::string& target, std::string& body) {
+    int fd = connectToServer(options);
+    if (fd < 0) return -1;
+    
+    std::string request = "GET " + target + " HTTP/1.0\r\nHost: localhost\r\n\r\n";
+    if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(request.size())) {
+        close(fd);
+        return -1;
+    }
+    
+    std::string response;
+    char buffer[16384];
+    ssize_t received;
+    while ((received = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+        response.append(buffer, static_cast<size_t>(received));
+    }
+    close(fd);
+    
+    size_t header_end = response.find("\r\n\r\n");
+    if (response.compare(0, 5, "HTTP/") != 0 || header_end == std::string::npos) return -1;
+    
+    body = response.substr(header_end + 4);
+    return std::atoi(response.c_str() + response.find(' ') + 1);
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t index = std::min(sorted.size() - 1, static_cast<size_t>(p / 100.0 * sorted.size()));
+    return sorted[index];
+}
+
+int main(int argc, char* argv[]) {
+    ClientOptions options;
+    
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        
+        if (arg == "--port" && has_value) options.port = std::atoi(argv[++i]);
+        else if (arg == "--socket" && has_value) options.socket_path = argv[++i];
+        else if (arg == "--connections" && has_value) options.connections = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--requests" && has_value) options.requests = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--max-level" && has_value) options.max_level = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--iterations" && has_value) options.iterations = std::atoi(argv[++i]);
+        else if (arg == "--format" && has_value) options.format = argv[++i];
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--port N | --socket PATH] [--connections N] [--requests N]\n"
+                      << "       [--max-level N] [--iterations N] [--format png|raw]" << std::endl;
+            return 1;
+        }
+    }
+    
+    std::atomic<int> next_request(0);
+    std::atomic<int> ok(0), rejected(0), failed(0);
+    std::atomic<long long> bytes(0);
+    std::mutex latency_mutex;
+    std::vector<double> latencies;
+    
+    auto start = std::chrono::high_resolution_clock::now();
+    
+    std::vector<std::thread> workers;
+    for (int c = 0; c < options.connections; ++c) {
+        workers.emplace_back([&, c] {
+            // Few levels and many clients means repeated tiles, which is
+            // what exercises request coalescing
+            std::mt19937 rng(1234 + c);
+            std::vector<double> local_latencies;
+            
+            while (next_request++ < options.requests) {
+                int level = std::uniform_int_distribution<int>(0, options.max_level)(rng);
+                int tiles = 1 << level;
+                int x = std::uniform_int_distribution<int>(0, tiles - 1)(rng);
+                int y = std::uniform_int_distribution<int>(0, tiles - 1)(rng);
+                
+                std::ostringstream target;
+                target << "/tile/" << level << "/" << x << "/" << y << "." << options.format
+                       << "?iterations=" << options.iterations;
+                
+                std::string body;
+                auto request_start = std::chrono::high_resolution_clock::now();
+                int status = httpGet(options, target.str(), body);
+                auto request_end = std::chrono::high_resolution_clock::now();
+                
+                if (status == 200) {
+                    ++ok;
+                    bytes += static_cast<long long>(body.size());
+                    local_latencies.push_back(std::chrono::duration<double, std::milli>(request_end - request_start).count());
+                } else if (status == 503) {
+                    ++rejected;
+                } else {
+                    ++failed;
+                }
+            }
+            
+            std::lock_guard<std::mutex> lock(latency_mutex);
+            latencies.insert(latencies.end(), local_latencies.begin(), local_latencies.end());
+        });
+    }
+    
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    auto end = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::sort(latencies.begin(), latencies.end());
+    
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Requests: " << options.requests << " over " << options.connections << " connections" << std::endl;
+    std::cout << "OK: " << ok << "  Rejected (503): " << rejected << "  Failed: " << failed << std::endl;
+    std::cout << "Throughput: " << ok / seconds << " tiles/s, "
+              << bytes / seconds / (1024.0 * 1024.0) << " MB/s" << std::endl;
+    std::cout << "Latency p50: " << percentile(latencies, 50) << " ms  p95: " << percentile(latencies, 95)
+              << " ms  p99: " << percentile(latencies, 99) << " ms  max: "
+              << (latencies.empty() ? 0.0 : latencies.back()) << " ms" << std::endl;
+    
+    std::string stats;
+    if (httpGet(options, "/stats", stats) == 200) {
+        std::cout << "\nServer stats:\n" << stats;
+    }
+    
+    return failed > 0 ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,311 @@
+#include "tile_server.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const size_t MAX_REQUEST_BYTES = 8192;
+
+#ifndef _WIN32
+bool sendAll(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+        if (sent <= 0) return false;
+        data += sent;
+        length -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+void sendResponse(int fd, int status, const std::string& reason, const std::string& content_type,
+                  const char* body, size_t length) {
+    std::ostringstream header;
+    header << "HTTP/1.0 " << status << " " << reason << "\r\n"
+           << "Content-Type: " << content_type << "\r\n"
+           << "Content-Length: " << length << "\r\n"
+           << "Connection: close\r\n\r\n";
+    std::string text = header.str();
+    if (sendAll(fd, text.data(), text.size())) {
+        sendAll(fd, body, length);
+    }
+}
+
+void sendText(int fd, int status, const std::string& reason, const std::string& body) {
+    sendResponse(fd, status, reason, "text/plain", body.data(), body.size());
+}
+
+void setTimeouts(int fd, int seconds) {
+    timeval timeout = {};
+    timeout.tv_sec = seconds;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+#endif
+
+bool parseInt(const std::string& text, int& value) {
+    if (text.empty()) return false;
+    char* end = nullptr;
+    long parsed = std::strtol(text.c_str(), &end, 10);
+    if (*end != '\0' || parsed < -2147483647L || parsed > 2147483647L) return false;
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+} // namespace
+
+TileServer::TileServer(TileService& service)
+    : service_(service), listen_fd_(-1), running_(false) {
+}
+
+TileServer::~TileServer() {
+#ifndef _WIN32
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+    }
+    if (!unix_path_.empty()) {
+        unlink(unix_path_.c_str());
+    }
+#endif
+}
+
+bool TileServer::parseTileTarget(const std::string& target, TileRequest& request, std::string& error) {
+    size_t query_start = target.find('?');
+    std::string path = target.substr(0, query_start);
+    std::string query = query_start == std::string::npos ? "" : target.substr(query_start + 1);
+    
+    const std::string prefix = "/tile/";
+    if (path.compare(0, prefix.size(), prefix) != 0) {
+        error = "unknown path";
+        return false;
+    }
+    
+    // {level}/{x}/{y}.{png|raw}
+    std::string rest = path.substr(prefix.size());
+    size_t dot = rest.rfind('.');
+    std::string extension = dot == std::string::npos ? "png" : rest.substr(dot + 1);
+    rest = rest.substr(0, dot);
+    
+    if (extension == "png") {
+        request.format = TileFormat::PNG;
+    } else if (extension == "raw") {
+        request.format = TileFormat::RAW;
+    } else {
+        error = "format must be png or raw";
+        return false;
+    }
+    
+    std::istringstream parts(rest);
+    std::string level, x, y, extra;
+    if (!std::getline(parts, level, '/') || !std::getline(parts, x, '/') || !std::getline(parts, y, '/') ||
+        std::getline(parts, extra, '/') ||
+        !parseInt(level, request.level) || !parseInt(x, request.x) || !parseInt(y, request.y)) {
+        error = "expected /tile/{level}/{x}/{y}.{png|raw}";
+        return false;
+    }
+    
+    std::istringstream params(query);
+    std::string param;
+    while (std::getline(params, param, '&')) {
+        size_t equals = param.find('=');
+        std::string name = param.substr(0, equals);
+        std::string value = equals == std::string::npos ? "" : param.substr(equals + 1);
+        
+        int* target_value = nullptr;
+        if (name == "iterations") target_value = &request.iterations;
+        else if (name == "palette") target_value = &request.palette;
+        else if (name == "priority") target_value = &request.priority;
+        else continue;
+        
+        if (!parseInt(value, *target_value)) {
+            error = "invalid value for " + name;
+            return false;
+        }
+    }
+    
+    return request.isValid(error);
+}
+
+#ifdef _WIN32
+
+bool TileServer::listenTCP(int) {
+    std::cerr << "Tile service mode is not supported on Windows" << std::endl;
+    return false;
+}
+
+bool TileServer::listenUnix(const std::string&) {
+    std::cerr << "Tile service mode is not supported on Windows" << std::endl;
+    return false;
+}
+
+void TileServer::run() {
+}
+
+void TileServer::handleConnection(int) {
+}
+
+void TileServer::closeConnection(int) {
+}
+
+#else
+
+bool TileServer::listenTCP(int port) {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) {
+        std::cerr << "socket() failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    
+    int reuse = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // Local clients only
+    
+    if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        listen(listen_fd_, 128) < 0) {
+        std::cerr << "Cannot listen on 127.0.0.1:" << port << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    
+    std::cout << "Tile service listening on http://127.0.0.1:" << port << std::endl;
+    return true;
+}
+
+bool TileServer::listenUnix(const std::string& path) {
+    sockaddr_un address = {};
+    if (path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "Socket path too long: " << path << std::endl;
+        return false;
+    }
+    
+    listen_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) {
+        std::cerr << "socket() failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    unlink(path.c_str());
+    
+    if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        listen(listen_fd_, 128) < 0) {
+        std::cerr << "Cannot listen on " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    
+    unix_path_ = path;
+    std::cout << "Tile service listening on unix:" << path << std::endl;
+    return true;
+}
+
+void TileServer::run() {
+    running_ = true;
+    
+    while (running_) {
+        // Wake up regularly so stop() is noticed without a connection
+        pollfd listener = {listen_fd_, POLLIN, 0};
+        int ready = poll(&listener, 1, 200);
+        if (ready < 0 && errno != EINTR) {
+            std::cerr << "poll() failed: " << std::strerror(errno) << std::endl;
+            break;
+        }
+        if (ready <= 0) continue;
+        
+        int fd = accept(listen_fd_, nullptr, nullptr);
+        if (fd < 0) continue;
+        setTimeouts(fd, SOCKET_TIMEOUT_SECONDS);
+        
+        {
+            std::lock_guard<std::mutex> lock(connections_mutex_);
+            if (static_cast<int>(connections_.size()) < MAX_CONNECTIONS) {
+                connections_.insert(fd);
+                std::thread(&TileServer::handleConnection, this, fd).detach();
+                continue;
+            }
+        }
+        
+        sendText(fd, 503, "Service Unavailable", "too many connections\n");
+        close(fd);
+    }
+    
+    // Unblock handlers still waiting on their client, then let them finish
+    // before the service goes away
+    std::unique_lock<std::mutex> lock(connections_mutex_);
+    for (int fd : connections_) {
+        shutdown(fd, SHUT_RDWR);
+    }
+    connections_cv_.wait(lock, [this] { return connections_.empty(); });
+}
+
+void TileServer::handleConnection(int fd) {
+    std::string request;
+    char buffer[1024];
+    
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < MAX_REQUEST_BYTES) {
+        ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+        if (received <= 0) break;
+        request.append(buffer, static_cast<size_t>(received));
+    }
+    
+    std::istringstream line(request.substr(0, request.find("\r\n")));
+    std::string method, target;
+    line >> method >> target;
+    
+    if (method != "GET") {
+        sendText(fd, 405, "Method Not Allowed", "only GET is supported\n");
+    } else if (target == "/stats") {
+        sendText(fd, 200, "OK", service_.getStats());
+    } else {
+        TileRequest tile;
+        std::string error;
+        std::shared_future<TileResponse> result;
+        
+        if (!parseTileTarget(target, tile, error)) {
+            sendText(fd, 400, "Bad Request", error + "\n");
+        } else {
+            SubmitStatus status = service_.submit(tile, result);
+            if (status == SubmitStatus::QUEUE_FULL) {
+                sendText(fd, 503, "Service Unavailable", "tile queue full\n");
+            } else if (status == SubmitStatus::STOPPING) {
+                sendText(fd, 503, "Service Unavailable", "service stopping\n");
+            } else {
+                const TileResponse& response = result.get();
+                if (response.ok) {
+                    sendResponse(fd, 200, "OK", response.content_type,
+                                 reinterpret_cast<const char*>(response.data.data()), response.data.size());
+                } else {
+                    sendText(fd, 500, "Internal Server Error", response.error + "\n");
+                }
+            }
+        }
+    }
+    
+    closeConnection(fd);
+}
+
+void TileServer::closeConnection(int fd) {
+    // Closed under the lock so run() never shuts down a reused descriptor
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    close(fd);
+    connections_.erase(fd);
+    connections_cv_.notify_all();
+}
+
+#endif
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include "tile_service.h"
+
+// Minimal HTTP/1.0 front end for TileService, listening on localhost TCP
+// or a Unix domain socket. One short-lived thread per connection, up to
+// MAX_CONNECTIONS at once with send/receive timeouts so a stalled client
+// cannot hold a thread for long; the actual work is bounded by the
+// service queue.
+//
+//   GET /tile/{level}/{x}/{y}.png?iterations=256&palette=0&priority=N
+//   GET /tile/{level}/{x}/{y}.raw   (ARGB8888, little-endian)
+//   GET /stats
+class TileServer {
+public:
+    explicit TileServer(TileService& service);
+    ~TileServer();
+    
+    bool listenTCP(int port);
+    bool listenUnix(const std::string& path);
+    
+    static const int MAX_CONNECTIONS = 64;
+    static const int SOCKET_TIMEOUT_SECONDS = 5;
+    
+    // Accept loop, returns after stop() or a fatal socket error. On the way
+    // out it shuts down the sockets still open and waits for their threads.
+    void run();
+    // Only flips a flag, so it is safe to call from a signal handler
+    void stop() { running_ = false; }
+    
+    // Parses a request target; exposed for the bundled client and tests
+    static bool parseTileTarget(const std::string& target, TileRequest& request, std::string& error);
+
+private:
+    void handleConnection(int fd);
+    void closeConnection(int fd);
+    
+    TileService& service_;
+    int listen_fd_;
+    std::string unix_path_;
+    std::atomic<bool> running_;
+    
+    std::mutex connections_mutex_;
+    std::condition_variable connections_cv_;
+    std::unordered_set<int> connections_; // Sockets owned by a handler thread
+};
@@ -0,0 +1,300 @@
+#include "tile_service.h"
+#include "color_palette.h"
+#include "png_writer.h"
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+bool TileRequest::isValid(std::string& error) const {
+    // Beyond level 40 neighbouring pixels collapse to the same double
+    if (level < 0 || level > 40) {
+        error = "level must be between 0 and 40";
+        return false;
+    }
+    
+    int64_t tiles = int64_t(1) << level;
+    if (x < 0 || y < 0 || x >= tiles || y >= tiles) {
+        error = "tile coordinates out of range for level";
+        return false;
+    }
+    
+    if (iterations < 1 || iterations > 65536) {
+        error = "iterations must be between 1 and 65536";
+        return false;
+    }
+    
+    if (palette < 0 || palette > ColorPalette::ELECTRIC) {
+        error = "unknown palette";
+        return false;
+    }
+    
+    return true;
+}
+
+std::string TileRequest::key() const {
+    std::ostringstream oss;
+    oss << level << "/" << x << "/" << y << "/" << iterations << "/" << palette << "/"
+        << (format == TileFormat::PNG ? "png" : "raw");
+    return oss.str();
+}
+
+MandelbrotParams TileRequest::toParams() const {
+    double span = 4.0 / std::ldexp(1.0, level);
+    
+    MandelbrotParams params;
+    params.center_x = -2.5 + (x + 0.5) * span;
+    params.center_y = -2.0 + (y + 0.5) * span;
+    params.zoom = std::ldexp(1.0, level);
+    params.max_iterations = iterations;
+    params.width = TileService::TILE_SIZE;
+    params.height = TileService::TILE_SIZE;
+    return params;
+}
+
+LatencyHistogram::LatencyHistogram() : count_(0) {
+    for (auto& bucket : buckets_) {
+        bucket = 0;
+    }
+}
+
+void LatencyHistogram::record(double ms) {
+    double us = std::max(1.0, ms * 1000.0);
+    int bucket = std::min(BUCKETS - 1, static_cast<int>(std::log2(us)));
+    ++buckets_[bucket];
+    ++count_;
+}
+
+double LatencyHistogram::getPercentile(double percentile) const {
+    uint64_t total = count_;
+    if (total == 0) return 0.0;
+    
+    // Report the upper bound of the bucket holding the requested rank
+    uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * total));
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+        seen += buckets_[i];
+        if (seen >= rank) {
+            return std::ldexp(1.0, i + 1) / 1000.0;
+        }
+    }
+    return std::ldexp(1.0, BUCKETS) / 1000.0;
+}
+
+std::string LatencyHistogram::toString(const std::string& name) const {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(3);
+    oss << name << ": count " << count_
+        << " p50<=" << getPercentile(50) << "ms"
+        << " p95<=" << getPercentile(95) << "ms"
+        << " p99<=" << getPercentile(99) << "ms\n";
+    
+    for (int i = 0; i < BUCKETS; ++i) {
+        uint64_t count = buckets_[i];
+        if (count == 0) continue;
+        oss << "  [" << std::ldexp(1.0, i) / 1000.0 << ", " << std::ldexp(1.0, i + 1) / 1000.0
+            << ") ms: " << count << "\n";
+    }
+    return oss.str();
+}
+
+TileService::TileService(size_t queue_capacity, int batch_size)
+    : queue_capacity_(queue_capacity), batch_size_(batch_size), next_sequence_(0), running_(false),
+      requests_(0), coalesced_(0), rejected_(0), batches_(0), tiles_rendered_(0) {
+}
+
+TileService::~TileService() {
+    stop();
+}
+
+void TileService::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) return;
+    
+    running_ = true;
+    dispatcher_ = std::thread(&TileService::dispatch, this);
+}
+
+void TileService::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) return;
+        running_ = false;
+    }
+    queue_cv_.notify_all();
+    
+    if (dispatcher_.joinable()) {
+        dispatcher_.join();
+    }
+    
+    // Fail whatever is still queued so no client waits forever
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (!queue_.empty()) {
+        TileResponse response;
+        response.error = "service stopped";
+        queue_.top()->promise.set_value(response);
+        queue_.pop();
+    }
+    in_flight_.clear();
+}
+
+SubmitStatus TileService::submit(const TileRequest& request, std::shared_future<TileResponse>& result) {
+    ++requests_;
+    
+    TileRequest normalized = request;
+    if (normalized.priority < 0) {
+        normalized.priority = normalized.level; // Coarse tiles first
+    }
+    std::string key = normalized.key();
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    if (!running_) {
+        ++rejected_;
+        return SubmitStatus::STOPPING;
+    }
+    
+    auto existing = in_flight_.find(key);
+    if (existing != in_flight_.end()) {
+        ++coalesced_;
+        result = existing->second->future;
+        return SubmitStatus::ACCEPTED;
+    }
+    
+    if (queue_.size() >= queue_capacity_) {
+        ++rejected_;
+        return SubmitStatus::QUEUE_FULL;
+    }
+    
+    auto job = std::make_shared<Job>();
+    job->request = normalized;
+    job->key = key;
+    job->sequence = next_sequence_++;
+    job->submitted = std::chrono::high_resolution_clock::now();
+    job->future = job->promise.get_future().share();
+    
+    in_flight_[key] = job;
+    queue_.push(job);
+    result = job->future;
+    
+    queue_cv_.notify_one();
+    return SubmitStatus::ACCEPTED;
+}
+
+void TileService::dispatch() {
+    std::vector<std::shared_ptr<Job>> batch;
+    
+    while (true) {
+        batch.clear();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            queue_cv_.wait(lock, [this] { return !running_ || !queue_.empty(); });
+            if (!running_) return;
+            
+            while (!queue_.empty() && static_cast<int>(batch.size()) < batch_size_) {
+                batch.push_back(queue_.top());
+                queue_.pop();
+            }
+        }
+        
+        auto start = std::chrono::high_resolution_clock::now();
+        for (const auto& job : batch) {
+            queue_wait_.record(std::chrono::duration<double, std::milli>(start - job->submitted).count());
+        }
+        
+        renderBatch(batch);
+        
+        auto end = std::chrono::high_resolution_clock::now();
+        batch_time_.record(std::chrono::duration<double, std::milli>(end - start).count());
+        ++batches_;
+        tiles_rendered_ += batch.size();
+    }
+}
+
+void TileService::renderBatch(std::vector<std::shared_ptr<Job>>& batch) {
+    const int count = static_cast<int>(batch.size());
+    std::vector<TileResponse> responses(count);
+    
+    if (count == 1) {
+        // A lone tile gets the whole thread pool
+        MandelbrotCalculator calculator(TILE_SIZE, TILE_SIZE);
+        responses[0] = renderTile(batch[0]->request, calculator, true);
+    } else {
+        // Several tiles: one tile per thread, dynamic because tile cost
+        // varies by orders of magnitude between exterior and boundary
+        #pragma omp parallel
+        {
+            MandelbrotCalculator calculator(TILE_SIZE, TILE_SIZE);
+            #pragma omp for schedule(dynamic, 1)
+            for (int i = 0; i < count; ++i) {
+                responses[i] = renderTile(batch[i]->request, calculator, false);
+            }
+        }
+    }
+    
+    auto end = std::chrono::high_resolution_clock::now();
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (int i = 0; i < count; ++i) {
+        in_flight_.erase(batch[i]->key);
+        batch[i]->promise.set_value(std::move(responses[i]));
+        latency_.record(std::chrono::duration<double, std::milli>(end - batch[i]->submitted).count());
+    }
+}
+
+TileResponse TileService::renderTile(const TileRequest& request, MandelbrotCalculator& calculator, bool parallel) {
+    MandelbrotParams params = request.toParams();
+    if (parallel) {
+        calculator.calculateParallel(params);
+    } else {
+        calculator.calculate(params);
+    }
+    
+    ColorPalette palette(static_cast<ColorPalette::PaletteType>(request.palette));
+    const IterationBuffer& iterations = calculator.getIterations();
+    
+    std::vector<uint32_t> pixels(TILE_SIZE * TILE_SIZE);
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        Color color = palette.getColor(iterations[i], params.max_iterations);
+        pixels[i] = (color.a << 24) | (color.r << 16) | (color.g << 8) | color.b;
+    }
+    
+    TileResponse response;
+    response.ok = true;
+    if (request.format == TileFormat::PNG) {
+        response.content_type = "image/png";
+        response.data = encodePNG(pixels.data(), TILE_SIZE, TILE_SIZE);
+    } else {
+        response.content_type = "application/octet-stream";
+        response.data.resize(pixels.size() * sizeof(uint32_t));
+        for (size_t i = 0; i < pixels.size(); ++i) {
+            response.data[i * 4 + 0] = static_cast<uint8_t>(pixels[i]);
+            response.data[i * 4 + 1] = static_cast<uint8_t>(pixels[i] >> 8);
+            response.data[i * 4 + 2] = static_cast<uint8_t>(pixels[i] >> 16);
+            response.data[i * 4 + 3] = static_cast<uint8_t>(pixels[i] >> 24);
+        }
+    }
+    return response;
+}
+
+std::string TileService::getStats() const {
+    size_t queued;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queued = queue_.size();
+    }
+    
+    uint64_t batches = batches_;
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(2);
+    oss << "requests " << requests_ << "\n";
+    oss << "coalesced " << coalesced_ << "\n";
+    oss << "rejected " << rejected_ << "\n";
+    oss << "queued " << queued << " / " << queue_capacity_ << "\n";
+    oss << "tiles_rendered " << tiles_rendered_ << "\n";
+    oss << "batches " << batches << " (avg size "
+        << (batches > 0 ? static_cast<double>(tiles_rendered_) / batches : 0.0) << ")\n";
+    oss << latency_.toString("tile_latency");
+    oss << queue_wait_.toString("queue_wait");
+    oss << batch_time_.toString("batch_render");
+    return oss.str();
+}
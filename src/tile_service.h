@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "mandelbrot.h"
+
+enum class TileFormat {
+    PNG,
+    RAW // ARGB8888, row-major, little-endian
+};
+
+// One map tile: level 0 is a single tile covering [-2.5, 1.5] x [-2, 2],
+// every level splits each tile into four
+struct TileRequest {
+    int level = 0;
+    int x = 0;
+    int y = 0;
+    int iterations = 256;
+    int palette = 0;
+    TileFormat format = TileFormat::PNG;
+    int priority = -1; // Lower is served first, defaults to the level
+    
+    bool isValid(std::string& error) const;
+    std::string key() const;
+    MandelbrotParams toParams() const;
+};
+
+enum class SubmitStatus {
+    ACCEPTED,    // result becomes ready once the tile is rendered
+    QUEUE_FULL,  // Try again later
+    STOPPING     // The service is shutting down
+};
+
+struct TileResponse {
+    bool ok = false;
+    std::string error;
+    std::string content_type;
+    std::vector<uint8_t> data;
+};
+
+// Log2-bucketed latency histogram in microseconds, safe to record from
+// several threads
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+    
+    void record(double ms);
+    uint64_t getCount() const { return count_; }
+    double getPercentile(double percentile) const;
+    std::string toString(const std::string& name) const;
+
+private:
+    static const int BUCKETS = 32; // Bucket i holds [2^i, 2^(i+1)) us
+    std::atomic<uint64_t> buckets_[BUCKETS];
+    std::atomic<uint64_t> count_;
+};
+
+// Renders tiles with MandelbrotCalculator + ColorPalette behind a bounded
+// priority queue. Identical requests that are queued or rendering share one
+// result, and the dispatcher renders several tiles per batch so the thread
+// pool stays busy even though a single tile is small.
+class TileService {
+public:
+    static const int TILE_SIZE = 256;
+    
+    TileService(size_t queue_capacity = 256, int batch_size = 8);
+    ~TileService();
+    
+    void start();
+    void stop();
+    
+    // result is only set when the request is ACCEPTED
+    SubmitStatus submit(const TileRequest& request, std::shared_future<TileResponse>& result);
+    
+    std::string getStats() const;
+
+private:
+    struct Job {
+        TileRequest request;
+        std::string key;
+        uint64_t sequence;
+        std::chrono::high_resolution_clock::time_point submitted;
+        std::promise<TileResponse> promise;
+        std::shared_future<TileResponse> future;
+    };
+    
+    struct JobOrder {
+        bool operator()(const std::shared_ptr<Job>& a, const std::shared_ptr<Job>& b) const {
+            if (a->request.priority != b->request.priority) return a->request.priority > b->request.priority;
+            return a->sequence > b->sequence;
+        }
+    };
+    
+    void dispatch();
+    void renderBatch(std::vector<std::shared_ptr<Job>>& batch);
+    static TileResponse renderTile(const TileRequest& request, MandelbrotCalculator& calculator, bool parallel);
+    
+    size_t queue_capacity_;
+    int batch_size_;
+    
+    mutable std::mutex mutex_;
+    std::condition_variable queue_cv_;
+    std::priority_queue<std::shared_ptr<Job>, std::vector<std::shared_ptr<Job>>, JobOrder> queue_;
+    std::unordered_map<std::string, std::shared_ptr<Job>> in_flight_;
+    uint64_t next_sequence_;
+    bool running_;
+    std::thread dispatcher_;
+    
+    std::atomic<uint64_t> requests_;
+    std::atomic<uint64_t> coalesced_;
+    std::atomic<uint64_t> rejected_;
+    std::atomic<uint64_t> batches_;
+    std::atomic<uint64_t> tiles_rendered_;
+    LatencyHistogram latency_;
+    LatencyHistogram queue_wait_;
+    LatencyHistogram batch_time_;
+};
@@ -0,0 +1,183 @@
+#include "zoom_prefetcher.h"
+#include <algorithm>
+
+double ZoomPrefetcher::Stats::getHitRate() const {
+    uint64_t frames = hits + waits + misses;
+    return frames > 0 ? static_cast<double>(hits) / frames : 0.0;
+}
+
+double ZoomPrefetcher::Stats::getWaitRate() const {
+    uint64_t frames = hits + waits + misses;
+    return frames > 0 ? static_cast<double>(waits) / frames : 0.0;
+}
+
+ZoomPrefetcher::ZoomPrefetcher(int thread_count, const AffinityConfig& affinity, int depth)
+    : thread_count_(thread_count), affinity_(affinity), depth_(std::max(1, depth)),
+      zoom_factor_(1.0), computing_(false), active_(false), stop_(false), foreground_busy_(false),
+      generation_(0) {
+}
+
+ZoomPrefetcher::~ZoomPrefetcher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    work_cv_.notify_all();
+    ready_cv_.notify_all();
+    resume_cv_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+bool ZoomPrefetcher::sameFrame(const MandelbrotParams& a, const MandelbrotParams& b) {
+    // Exact comparison: the path repeats the caller's zoom multiplications,
+    // so a frame on it matches bit for bit
+    return a.center_x == b.center_x && a.center_y == b.center_y && a.zoom == b.zoom &&
+           a.max_iterations == b.max_iterations && a.width == b.width && a.height == b.height;
+}
+
+bool ZoomPrefetcher::take(const MandelbrotParams& params, double zoom_factor, IterationBuffer& iterations) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const bool on_path = active_ && zoom_factor == zoom_factor_;
+    
+    // Computing the frame again here would only compete with the worker
+    bool waited = false;
+    if (on_path && queue_.empty() && computing_ && sameFrame(in_flight_, params)) {
+        ready_cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+        waited = true;
+    }
+    
+    if (on_path && !queue_.empty() && sameFrame(queue_.front().params, params)) {
+        if (waited) {
+            ++stats_.waits;
+        } else {
+            ++stats_.hits;
+        }
+        iterations.swap(queue_.front().iterations);
+        recycle(queue_.front().iterations);
+        queue_.pop_front();
+        lock.unlock();
+        work_cv_.notify_one();
+        return true;
+    }
+    
+    // The caller computes this frame, the worker starts on the one after
+    ++stats_.misses;
+    dropQueue();
+    resume_cv_.notify_all();
+    next_ = params;
+    next_.zoom *= zoom_factor;
+    zoom_factor_ = zoom_factor;
+    active_ = true;
+    
+    // The worker and its pool start with the first path, not with the app
+    if (!worker_.joinable()) {
+        worker_ = std::thread(&ZoomPrefetcher::workerLoop, this);
+    }
+    lock.unlock();
+    work_cv_.notify_one();
+    return false;
+}
+
+void ZoomPrefetcher::invalidate() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!active_) return;
+    
+    dropQueue();
+    active_ = false;
+    resume_cv_.notify_all(); // The frame in flight can stop now
+}
+
+void ZoomPrefetcher::setForegroundBusy(bool busy) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        foreground_busy_ = busy;
+    }
+    if (!busy) {
+        resume_cv_.notify_all();
+    }
+}
+
+ZoomPrefetcher::Stats ZoomPrefetcher::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats = stats_;
+    stats.queued = queue_.size();
+    return stats;
+}
+
+void ZoomPrefetcher::resetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_ = Stats();
+}
+
+void ZoomPrefetcher::dropQueue() {
+    for (auto& frame : queue_) {
+        recycle(frame.iterations);
+    }
+    queue_.clear();
+    ++generation_;
+}
+
+void ZoomPrefetcher::recycle(IterationBuffer& buffer) {
+    // One spare per queue slot plus the frame in flight is all the worker can use
+    if (static_cast<int>(spares_.size()) <= depth_) {
+        spares_.push_back(std::move(buffer));
+    }
+    IterationBuffer().swap(buffer);
+}
+
+bool ZoomPrefetcher::waitForCpus(unsigned long long generation) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    resume_cv_.wait(lock, [this, generation] {
+        return stop_ || !foreground_busy_ || generation != generation_;
+    });
+    return !stop_ && generation == generation_;
+}
+
+void ZoomPrefetcher::workerLoop() {
+    // Built on this thread, so the pool pins (and later restores) this
+    // thread as its thread 0 rather than the one that owns the prefetcher
+    MandelbrotCalculator calculator(1, 1, ParallelBackend::THREAD_POOL, thread_count_, affinity_);
+    
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        work_cv_.wait(lock, [this] {
+            return stop_ || (active_ && static_cast<int>(queue_.size()) < depth_);
+        });
+        if (stop_) return;
+        
+        const unsigned long long generation = generation_;
+        const MandelbrotParams params = next_;
+        in_flight_ = params;
+        next_.zoom *= zoom_factor_;
+        computing_ = true;
+        
+        IterationBuffer buffer;
+        if (!spares_.empty()) {
+            buffer.swap(spares_.back());
+            spares_.pop_back();
+        }
+        lock.unlock();
+        
+        // The spare goes in, the finished frame comes out; chunks wait while
+        // the render thread is busy and are skipped once the frame is stale
+        calculator.setChunkGate([this, generation] { return waitForCpus(generation); });
+        calculator.swapIterations(buffer);
+        calculator.calculateParallel(params);
+        calculator.swapIterations(buffer);
+        
+        lock.lock();
+        computing_ = false;
+        if (stop_) return;
+        if (generation != generation_) {
+            ++stats_.discarded;
+            recycle(buffer);
+            continue;
+        }
+        queue_.push_back(Frame());
+        queue_.back().params = params;
+        queue_.back().iterations.swap(buffer);
+        ready_cv_.notify_all();
+    }
+}
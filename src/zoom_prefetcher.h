@@ -0,0 +1,98 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "mandelbrot.h"
+
+// Speculatively computes upcoming auto-zoom frames. The path is fully
+// determined by the frame on screen and the zoom factor, so a background
+// thread with its own calculator runs ahead along it and keeps up to depth
+// finished iteration buffers in a queue. Leaving the path (pan, iteration
+// limit, resize, another factor) drops the queue by bumping a generation
+// counter; a frame still being computed for an old generation is thrown
+// away when it finishes. Colors are applied by the renderer afterwards, so
+// palette changes keep the queue.
+//
+// The worker's pool has as many threads as the render team, so it yields
+// while the render thread computes a frame itself (see setForegroundBusy):
+// a frame in progress pauses between chunks, and one for an old generation
+// stops at the next chunk instead of running to the end.
+class ZoomPrefetcher {
+public:
+    struct Stats {
+        uint64_t hits = 0;       // Frame was already queued
+        uint64_t waits = 0;      // Frame was being computed, taken once done
+        uint64_t misses = 0;     // Not on the path, computed by the caller
+        uint64_t discarded = 0;  // Finished for an old generation
+        size_t queued = 0;
+        
+        // Over all frames taken. A wait still blocks the render thread, so
+        // it is not counted as a hit
+        double getHitRate() const;
+        double getWaitRate() const;
+    };
+    
+    // The worker runs a std::thread pool backend, whose idle and paused
+    // threads sleep instead of spinning against the render thread's OpenMP
+    // team. It starts on the first take(), so an app that never prefetches
+    // never creates it
+    ZoomPrefetcher(int thread_count, const AffinityConfig& affinity = AffinityConfig(), int depth = 4);
+    ~ZoomPrefetcher();
+    
+    // Called with each auto-zoom frame before computing it; the frame after
+    // params has zoom params.zoom * zoom_factor. Returns true and swaps the
+    // frame's iteration counts into iterations if it was prefetched,
+    // otherwise restarts the path after params and returns false.
+    bool take(const MandelbrotParams& params, double zoom_factor, IterationBuffer& iterations);
+    
+    // Drops every queued frame and idles until the next take
+    void invalidate();
+    
+    // Brackets a frame the render thread computes itself after a miss; the
+    // worker pauses until it ends. Not to be held across take(), which may
+    // wait on the worker.
+    void setForegroundBusy(bool busy);
+    
+    Stats getStats() const;
+    void resetStats();
+    int getDepth() const { return depth_; }
+
+private:
+    struct Frame {
+        MandelbrotParams params;
+        IterationBuffer iterations;
+    };
+    
+    static bool sameFrame(const MandelbrotParams& a, const MandelbrotParams& b);
+    void workerLoop();
+    bool waitForCpus(unsigned long long generation);
+    
+    // mutex_ held
+    void dropQueue();
+    void recycle(IterationBuffer& buffer);
+    
+    const int thread_count_;
+    const AffinityConfig affinity_;
+    const int depth_;
+    
+    mutable std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable ready_cv_;
+    std::condition_variable resume_cv_;
+    std::deque<Frame> queue_;
+    std::vector<IterationBuffer> spares_;
+    MandelbrotParams next_;       // Next frame the worker starts
+    MandelbrotParams in_flight_;  // Valid while computing_
+    double zoom_factor_;
+    bool computing_;
+    bool active_;
+    bool stop_;
+    bool foreground_busy_;
+    unsigned long long generation_;
+    Stats stats_;
+    std::thread worker_; // Started and joined by the take() caller's thread
+};